@@ -0,0 +1,23 @@
+-- Keeps vehicles inside the world, turning them around at the edges. Batched: one call per step
+-- handles every vehicle using this script. Each vehicle only touches its own fields, so the batch can be
+-- split across the script workers (--script-workers N)
+local margin = 32
+
+return {
+	parallel = true,
+	update_all = function(entities, deltaTime)
+		local x, y = entities.position_x, entities.position_y
+		local vx, vy = entities.velocity_x, entities.velocity_y
+		local maxX, maxY = world_width - margin, world_height - margin
+
+		for i = 1, #entities do
+			local speedX, speedY = vx[i], vy[i]
+			if (speedX < 0 and x[i] < margin) or (speedX > 0 and x[i] > maxX) then
+				vx[i] = -speedX
+			end
+			if (speedY < 0 and y[i] < margin) or (speedY > 0 and y[i] > maxY) then
+				vy[i] = -speedY
+			end
+		end
+	end
+}
@@ -0,0 +1,22 @@
+-- Drives for two seconds, stops for one, and repeats. The loop runs as a coroutine started on the first update,
+-- owned by the entity, so it ends when the entity is killed
+local started = setmetatable({}, {__mode = "k"})
+
+return function(entity, deltaTime)
+	-- One loop per entity, keyed weakly by its handle
+	if started[entity] then
+		return
+	end
+	started[entity] = true
+
+	start_coroutine(function()
+		local body = entity.rigid_body
+		local speed = body.velocity_y
+		while true do
+			wait(2.0)
+			body.velocity_y = 0
+			wait(1.0)
+			body.velocity_y = speed
+		end
+	end)
+end
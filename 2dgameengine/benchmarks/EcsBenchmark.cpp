@@ -0,0 +1,246 @@
+// Measures Registry operations at several entity counts and writes a BenchmarkReport as JSON.
+//
+//   EcsBenchmark [--sizes 1000,100000,1000000] [--repeat 5] [--out file.json]
+//
+// Every repeat starts from a fresh Registry and runs the phases in order, each timed on its own:
+//   create            CreateEntity, per entity
+//   add_component     AddComponent, per component (three per entity)
+//   registry_update   Registry::Update registering new entities with three systems, per entity
+//   view_1..view_3    Iterating the systems that require one, two and three components, per entity
+//   signature_match   AddEntityToSystems on entities already registered, so only matching runs, per entity
+//   remove_component  RemoveComponent, per entity
+//   destroy           KillEntity plus the Registry::Update that applies it, per entity
+
+#include "../src/Benchmark/BenchmarkReport.h"
+#include "../src/ECS/ECS.h"
+#include "../src/ECS/Components/TransformComponent.h"
+#include "../src/ECS/Components/RigidBodyComponent.h"
+#include "../src/Logger/Logger.h"
+#include "../src/Profiler/AllocationTracker.h"
+#include "../src/Profiler/PerfCounters.h"
+#include "../src/Profiler/Profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct HealthComponent {
+	int health;
+
+	HealthComponent(int health = 100) {
+		this->health = health;
+	}
+};
+
+class TransformViewSystem: public System {
+	public:
+		TransformViewSystem() {
+			RequireComponent<TransformComponent>();
+		}
+};
+
+class MovementViewSystem: public System {
+	public:
+		MovementViewSystem() {
+			RequireComponent<TransformComponent>();
+			RequireComponent<RigidBodyComponent>();
+		}
+};
+
+class HealthViewSystem: public System {
+	public:
+		HealthViewSystem() {
+			RequireComponent<TransformComponent>();
+			RequireComponent<RigidBodyComponent>();
+			RequireComponent<HealthComponent>();
+		}
+};
+
+// Keeps view loops from being optimized away
+static volatile double sink;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PhaseTimer: Times one phase and adds its sample, hardware counters and allocations to the report
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class PhaseTimer {
+	private:
+		BenchmarkResult& result;
+		long long ops;
+		int repeats;
+		int64_t start;
+		PerfCounterValues startCounters;
+		AllocationStats startAllocations;
+
+	public:
+		PhaseTimer(BenchmarkReport& report, const char* name, long long size, long long ops, int repeats):
+			result(report.GetResult(name, size, "ns/op")), ops(ops), repeats(repeats) {
+			startAllocations = AllocationTracker::GetThreadStats();
+			PerfCounters::Read(startCounters);
+			start = Profiler::Now();
+		}
+
+		~PhaseTimer() {
+			const int64_t end = Profiler::Now();
+			PerfCounterValues endCounters;
+			const bool hasCounters = PerfCounters::Read(endCounters);
+			const AllocationStats endAllocations = AllocationTracker::GetThreadStats();
+
+			const double perOp = 1.0 / (static_cast<double>(ops) * repeats);
+			result.samples.push_back(static_cast<double>(end - start) / ops);
+			if (hasCounters) {
+				result.hasCounters = true;
+				for (int type = 0; type < PERF_COUNTER_COUNT; type++) {
+					result.countersPerOp[type] += (endCounters.values[type] - startCounters.values[type]) * perOp;
+				}
+			}
+			if (AllocationTracker::IsEnabled()) {
+				result.hasAllocations = true;
+				result.allocationsPerOp += (endAllocations.allocations - startAllocations.allocations) * perOp;
+			}
+		}
+};
+
+static double IterateOneComponent(const std::vector<Entity>& entities) {
+	double sum = 0.0;
+	for (const auto& entity: entities) {
+		sum += entity.GetComponent<TransformComponent>().position.x;
+	}
+	return sum;
+}
+
+static double IterateTwoComponents(const std::vector<Entity>& entities) {
+	double sum = 0.0;
+	for (const auto& entity: entities) {
+		auto& transform = entity.GetComponent<TransformComponent>();
+		const auto& rigidBody = entity.GetComponent<RigidBodyComponent>();
+		transform.position += rigidBody.velocity;
+		sum += transform.position.x;
+	}
+	return sum;
+}
+
+static double IterateThreeComponents(const std::vector<Entity>& entities) {
+	double sum = 0.0;
+	for (const auto& entity: entities) {
+		const auto& transform = entity.GetComponent<TransformComponent>();
+		const auto& rigidBody = entity.GetComponent<RigidBodyComponent>();
+		const auto& health = entity.GetComponent<HealthComponent>();
+		sum += transform.position.x + rigidBody.velocity.y + health.health;
+	}
+	return sum;
+}
+
+static void RunRepeat(BenchmarkReport& report, long long size, int repeats) {
+	Registry registry;
+	registry.AddSystem<TransformViewSystem>();
+	registry.AddSystem<MovementViewSystem>();
+	registry.AddSystem<HealthViewSystem>();
+
+	std::vector<Entity> entities;
+	entities.reserve(size);
+
+	{
+		PhaseTimer timer(report, "create", size, size, repeats);
+		for (long long i = 0; i < size; i++) {
+			entities.push_back(registry.CreateEntity());
+		}
+	}
+
+	{
+		PhaseTimer timer(report, "add_component", size, size * 3, repeats);
+		for (auto& entity: entities) {
+			const float value = static_cast<float>(entity.GetId());
+			entity.AddComponent<TransformComponent>(glm::vec2(value, value), glm::vec2(1.0, 1.0), 0.0);
+			entity.AddComponent<RigidBodyComponent>(glm::vec2(1.0, 0.5));
+			entity.AddComponent<HealthComponent>(100);
+		}
+	}
+
+	{
+		PhaseTimer timer(report, "registry_update", size, size, repeats);
+		registry.Update();
+	}
+
+	{
+		PhaseTimer timer(report, "view_1", size, size, repeats);
+		sink = IterateOneComponent(registry.GetSystem<TransformViewSystem>().GetSystemEntities());
+	}
+
+	{
+		PhaseTimer timer(report, "view_2", size, size, repeats);
+		sink = IterateTwoComponents(registry.GetSystem<MovementViewSystem>().GetSystemEntities());
+	}
+
+	{
+		PhaseTimer timer(report, "view_3", size, size, repeats);
+		sink = IterateThreeComponents(registry.GetSystem<HealthViewSystem>().GetSystemEntities());
+	}
+
+	{
+		PhaseTimer timer(report, "signature_match", size, size, repeats);
+		for (const auto& entity: entities) {
+			registry.AddEntityToSystems(entity);
+		}
+	}
+
+	{
+		PhaseTimer timer(report, "remove_component", size, size, repeats);
+		for (auto& entity: entities) {
+			entity.RemoveComponent<HealthComponent>();
+		}
+	}
+
+	{
+		PhaseTimer timer(report, "destroy", size, size, repeats);
+		for (const auto& entity: entities) {
+			registry.KillEntity(entity);
+		}
+		registry.Update();
+	}
+}
+
+int main(int argc, char* argv[]) {
+	std::vector<long long> sizes = {1000, 100000, 1000000};
+	int repeats = 5;
+	std::string outputPath = "-";
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+			sizes.clear();
+			for (char* item = strtok(argv[++i], ","); item; item = strtok(nullptr, ",")) {
+				sizes.push_back(strtoll(item, nullptr, 10));
+			}
+		} else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+			repeats = std::max(1, atoi(argv[++i]));
+		} else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+			outputPath = argv[++i];
+		} else {
+			fprintf(stderr, "Usage: %s [--sizes 1000,100000,1000000] [--repeat 5] [--out file.json]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	// Entity creation logs at debug level, keep that out of the measurements
+	Logger::SetLevel(LOG_LEVEL_WARNING);
+	Profiler::SetEnabled(false);
+
+	BenchmarkReport report("ecs");
+	report.SetMetadata("repeats", std::to_string(repeats));
+	report.SetMetadata("perf_counters", PerfCounters::IsAvailable() ? "yes" : "no");
+	report.SetMetadata("allocation_tracking", AllocationTracker::IsEnabled() ? "yes" : "no");
+
+	for (long long size: sizes) {
+		if (size <= 0) {
+			continue;
+		}
+		for (int repeat = 0; repeat < repeats; repeat++) {
+			RunRepeat(report, size, repeats);
+		}
+		fprintf(stderr, "ecs: %lld entities done\n", size);
+	}
+
+	return report.WriteJson(outputPath) ? 0 : 1;
+}
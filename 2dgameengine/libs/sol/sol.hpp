@@ -1236,6 +1236,7 @@ namespace sol {
 
 #include <cstdint>
 #include <memory>
+#include <limits>
 #include <array>
 #include <iterator>
 #include <iosfwd>
@@ -0,0 +1,44 @@
+#include "AssetStore.h"
+#include "../Logger/Logger.h"
+#include <SDL2/SDL_image.h>
+
+AssetStore::AssetStore() {
+	Logger::Log("AssetStore constructor called.");
+}
+
+AssetStore::~AssetStore() {
+	ClearAssets();
+	Logger::Log("AssetStore destructor called.");
+}
+
+void AssetStore::ClearAssets() {
+	for (auto texture: textures) {
+		SDL_DestroyTexture(texture.second);
+	}
+	textures.clear();
+}
+
+void AssetStore::AddTexture(SDL_Renderer* renderer, const std::string& assetId, const std::string& filePath) {
+	SDL_Texture* texture = IMG_LoadTexture(renderer, filePath.c_str());
+	if (!texture) {
+		LOG_ERROR("Error loading texture %s: %s", filePath.c_str(), IMG_GetError());
+		return;
+	}
+
+	// Replacing an asset must not leak the texture it shadows
+	auto existing = textures.find(assetId);
+	if (existing != textures.end()) {
+		SDL_DestroyTexture(existing->second);
+	}
+	textures[assetId] = texture;
+
+	LOG_INFO("New texture added to the AssetStore with id = %s", assetId.c_str());
+}
+
+SDL_Texture* AssetStore::GetTexture(const std::string& assetId) const {
+	auto texture = textures.find(assetId);
+	if (texture == textures.end()) {
+		return nullptr;
+	}
+	return texture->second;
+}
@@ -0,0 +1,159 @@
+#include "BenchmarkReport.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+	void WriteJsonString(FILE* file, const std::string& text) {
+		fputc('"', file);
+		for (char c: text) {
+			if (c == '"' || c == '\\') {
+				fputc('\\', file);
+			}
+			fputc(static_cast<unsigned char>(c) < 0x20 ? ' ' : c, file);
+		}
+		fputc('"', file);
+	}
+
+	// JSON has no NaN or infinity
+	void WriteJsonNumber(FILE* file, double value) {
+		if (std::isfinite(value)) {
+			fprintf(file, "%.6g", value);
+		} else {
+			fprintf(file, "null");
+		}
+	}
+}
+
+BenchmarkReport::BenchmarkReport(const std::string& suite): suite(suite) {
+}
+
+void BenchmarkReport::SetMetadata(const std::string& key, const std::string& value) {
+	for (auto& entry: metadata) {
+		if (entry.first == key) {
+			entry.second = value;
+			return;
+		}
+	}
+	metadata.push_back(std::make_pair(key, value));
+}
+
+BenchmarkResult& BenchmarkReport::GetResult(const std::string& name, long long size, const std::string& unit) {
+	for (auto& result: results) {
+		if (result.name == name && result.size == size) {
+			return result;
+		}
+	}
+	BenchmarkResult result;
+	result.name = name;
+	result.size = size;
+	result.unit = unit;
+	results.push_back(result);
+	return results.back();
+}
+
+const std::vector<BenchmarkResult>& BenchmarkReport::GetResults() const {
+	return results;
+}
+
+double BenchmarkReport::GetPercentile(std::vector<double> samples, double fraction) {
+	if (samples.empty()) {
+		return 0.0;
+	}
+	std::sort(samples.begin(), samples.end());
+	size_t rank = static_cast<size_t>(std::ceil(fraction * samples.size()));
+	rank = std::min(std::max<size_t>(rank, 1), samples.size());
+	return samples[rank - 1];
+}
+
+bool BenchmarkReport::WriteJson(const std::string& filePath) const {
+	const bool isStdout = filePath == "-";
+	FILE* file = isStdout ? stdout : fopen(filePath.c_str(), "w");
+	if (!file) {
+		LOG_ERROR("Error opening benchmark report %s", filePath.c_str());
+		return false;
+	}
+
+	fprintf(file, "{\n\"suite\": ");
+	WriteJsonString(file, suite);
+	fprintf(file, ",\n\"metadata\": {");
+	for (size_t i = 0; i < metadata.size(); i++) {
+		fprintf(file, "%s", i > 0 ? ", " : "");
+		WriteJsonString(file, metadata[i].first);
+		fprintf(file, ": ");
+		WriteJsonString(file, metadata[i].second);
+	}
+	fprintf(file, "},\n\"results\": [");
+
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchmarkResult& result = results[i];
+
+		double sum = 0.0;
+		double minimum = result.samples.empty() ? 0.0 : result.samples[0];
+		double maximum = minimum;
+		for (double sample: result.samples) {
+			sum += sample;
+			minimum = std::min(minimum, sample);
+			maximum = std::max(maximum, sample);
+		}
+		const double count = static_cast<double>(std::max<size_t>(result.samples.size(), 1));
+		const double mean = sum / count;
+		double squares = 0.0;
+		for (double sample: result.samples) {
+			squares += (sample - mean) * (sample - mean);
+		}
+		const double stddev = result.samples.size() > 1 ? std::sqrt(squares / (result.samples.size() - 1)) : 0.0;
+		const double median = GetPercentile(result.samples, 0.5);
+
+		fprintf(file, "%s\n{\"name\": ", i > 0 ? "," : "");
+		WriteJsonString(file, result.name);
+		fprintf(file, ", \"size\": %lld, \"unit\": ", result.size);
+		WriteJsonString(file, result.unit);
+		fprintf(file, ", \"samples\": [");
+		for (size_t j = 0; j < result.samples.size(); j++) {
+			fprintf(file, "%s", j > 0 ? ", " : "");
+			WriteJsonNumber(file, result.samples[j]);
+		}
+		fprintf(file, "], \"median\": ");
+		WriteJsonNumber(file, median);
+		fprintf(file, ", \"mean\": ");
+		WriteJsonNumber(file, mean);
+		fprintf(file, ", \"stddev\": ");
+		WriteJsonNumber(file, stddev);
+		fprintf(file, ", \"p95\": ");
+		WriteJsonNumber(file, GetPercentile(result.samples, 0.95));
+		fprintf(file, ", \"p99\": ");
+		WriteJsonNumber(file, GetPercentile(result.samples, 0.99));
+		fprintf(file, ", \"min\": ");
+		WriteJsonNumber(file, minimum);
+		fprintf(file, ", \"max\": ");
+		WriteJsonNumber(file, maximum);
+
+		if (result.unit == "ns/op" && median > 0.0) {
+			fprintf(file, ", \"ops_per_second\": ");
+			WriteJsonNumber(file, 1e9 / median);
+		}
+		if (result.hasCounters) {
+			fprintf(file, ", \"counters_per_op\": {");
+			for (int type = 0; type < PERF_COUNTER_COUNT; type++) {
+				fprintf(file, "%s\"%s\": ", type > 0 ? ", " : "", PerfCounters::GetName(static_cast<PerfCounterType>(type)));
+				WriteJsonNumber(file, result.countersPerOp[type]);
+			}
+			fprintf(file, "}");
+		}
+		if (result.hasAllocations) {
+			fprintf(file, ", \"allocations_per_op\": ");
+			WriteJsonNumber(file, result.allocationsPerOp);
+		}
+		fprintf(file, "}");
+	}
+
+	fprintf(file, "\n]\n}\n");
+	if (isStdout) {
+		fflush(file);
+	} else {
+		fclose(file);
+	}
+	return true;
+}
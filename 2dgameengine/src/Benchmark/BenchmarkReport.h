@@ -0,0 +1,55 @@
+#ifndef BENCHMARKREPORT_H
+#define BENCHMARKREPORT_H
+
+#include "../Profiler/PerfCounters.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+// One measured quantity at one problem size, with a sample per repeat
+struct BenchmarkResult {
+	std::string name;
+	long long size;              // Problem size, e.g. the entity count
+	std::string unit;            // Unit of the samples, "ns/op" makes the report add a throughput
+	std::vector<double> samples;
+
+	// Optional extras, averaged per operation over every repeat
+	bool hasCounters = false;
+	double countersPerOp[PERF_COUNTER_COUNT] = {};
+	bool hasAllocations = false;
+	double allocationsPerOp = 0.0;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// BenchmarkReport: Collects the results of a benchmark run and writes them as JSON. Every benchmark in the
+// engine uses this schema so the regression comparator reads all of them:
+//
+//   {"suite": "...", "metadata": {...}, "results": [{"name", "size", "unit", "samples", "median", "mean",
+//    "stddev", "p95", "p99", "min", "max", ["ops_per_second"], ["counters_per_op"], ["allocations_per_op"]}, ...]}
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class BenchmarkReport {
+	private:
+		std::string suite;
+		std::vector<std::pair<std::string, std::string>> metadata;
+		std::vector<BenchmarkResult> results;
+
+	public:
+		BenchmarkReport(const std::string& suite);
+
+		// Free form key/value pairs describing the run, e.g. seed or build flags
+		void SetMetadata(const std::string& key, const std::string& value);
+
+		// Returns the result for name and size, created empty on first use
+		BenchmarkResult& GetResult(const std::string& name, long long size, const std::string& unit);
+
+		const std::vector<BenchmarkResult>& GetResults() const;
+
+		// "-" writes to stdout
+		bool WriteJson(const std::string& filePath) const;
+
+		// Nearest rank percentile of unsorted samples
+		static double GetPercentile(std::vector<double> samples, double fraction);
+};
+
+#endif
@@ -0,0 +1,94 @@
+#include "FrameBenchmark.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+#include <cstring>
+
+FrameBenchmark::FrameBenchmark() {
+	expectedFrames = 0;
+}
+
+void FrameBenchmark::Reserve(size_t frames) {
+	expectedFrames = frames;
+	for (auto& scope: scopeSamples) {
+		scope.millis.reserve(frames);
+	}
+
+	// Enough for every scope the engine has, the vector is reused each frame
+	frameScopes.reserve(64);
+}
+
+void FrameBenchmark::RecordFrame() {
+	Profiler::GetLastFrameScopes(frameScopes);
+
+	for (const auto& total: frameScopes) {
+		ScopeSamples* samples = nullptr;
+		for (auto& scope: scopeSamples) {
+			if (scope.name == total.name) {
+				samples = &scope;
+				break;
+			}
+		}
+		if (!samples) {
+			ScopeSamples scope;
+			scope.name = total.name;
+			scope.millis.reserve(expectedFrames);
+			scope.hasCounters = false;
+			memset(scope.counters, 0, sizeof(scope.counters));
+			scope.allocations = 0;
+			scopeSamples.push_back(scope);
+			samples = &scopeSamples.back();
+		}
+
+		samples->millis.push_back(total.totalNanos / 1e6);
+		if (total.hasCounters) {
+			samples->hasCounters = true;
+			for (int type = 0; type < PERF_COUNTER_COUNT; type++) {
+				samples->counters[type] += static_cast<double>(total.counters.values[type]);
+			}
+		}
+		samples->allocations += total.allocations;
+	}
+}
+
+size_t FrameBenchmark::GetFrameCount() const {
+	for (const auto& scope: scopeSamples) {
+		if (strcmp(scope.name, "Frame") == 0) {
+			return scope.millis.size();
+		}
+	}
+	return 0;
+}
+
+void FrameBenchmark::AddToReport(BenchmarkReport& report, long long size) const {
+	for (const auto& scope: scopeSamples) {
+		const bool isFrame = strcmp(scope.name, "Frame") == 0;
+		BenchmarkResult& result = report.GetResult(isFrame ? "frame_time" : std::string("scope:") + scope.name, size, "ms");
+		result.samples = scope.millis;
+
+		// Extras become per frame averages over the frames the scope ran in
+		const double frames = static_cast<double>(std::max<size_t>(scope.millis.size(), 1));
+		if (scope.hasCounters) {
+			result.hasCounters = true;
+			for (int type = 0; type < PERF_COUNTER_COUNT; type++) {
+				result.countersPerOp[type] = scope.counters[type] / frames;
+			}
+		}
+		if (AllocationTracker::IsEnabled()) {
+			result.hasAllocations = true;
+			result.allocationsPerOp = scope.allocations / frames;
+		}
+	}
+}
+
+void FrameBenchmark::LogSummary() const {
+	for (const auto& scope: scopeSamples) {
+		if (strcmp(scope.name, "Frame") == 0) {
+			LOG_INFO("Benchmark: %zu frames, frame time p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms",
+				scope.millis.size(),
+				BenchmarkReport::GetPercentile(scope.millis, 0.50),
+				BenchmarkReport::GetPercentile(scope.millis, 0.95),
+				BenchmarkReport::GetPercentile(scope.millis, 0.99),
+				BenchmarkReport::GetPercentile(scope.millis, 1.0));
+		}
+	}
+}
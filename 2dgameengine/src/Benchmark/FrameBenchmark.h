@@ -0,0 +1,47 @@
+#ifndef FRAMEBENCHMARK_H
+#define FRAMEBENCHMARK_H
+
+#include "BenchmarkReport.h"
+#include "../Profiler/Profiler.h"
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FrameBenchmark: Turns the profiler's per-frame scope totals into a frame time distribution plus one per
+// subsystem. Call RecordFrame right after Profiler::BeginFrame, once per measured frame. Buffers are reserved
+// up front, so recording doesn't allocate during the run.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class FrameBenchmark {
+	private:
+		struct ScopeSamples {
+			const char* name;
+			std::vector<double> millis;
+			bool hasCounters;
+			double counters[PERF_COUNTER_COUNT];
+			uint64_t allocations;
+		};
+
+		size_t expectedFrames;
+		std::vector<ScopeSamples> scopeSamples;
+		std::vector<ProfileScopeTotal> frameScopes;
+
+	public:
+		FrameBenchmark();
+
+		// Sizes the sample buffers, so recording this many frames never reallocates
+		void Reserve(size_t frames);
+
+		// Adds the last finished frame as published by Profiler::BeginFrame
+		void RecordFrame();
+
+		size_t GetFrameCount() const;
+
+		// Adds "frame_time" and a "scope:<name>" result per profiler scope, all in milliseconds per frame
+		void AddToReport(BenchmarkReport& report, long long size) const;
+
+		// One line with the frame time percentiles
+		void LogSummary() const;
+};
+
+#endif
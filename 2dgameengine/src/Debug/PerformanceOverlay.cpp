@@ -0,0 +1,248 @@
+#include "PerformanceOverlay.h"
+#include "../Logger/Logger.h"
+#include <imgui/imgui.h>
+#include <imgui/imgui_sdl.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace {
+	// Compiler type names look like "14MovementSystem" for the plain classes used here, drop the length prefix
+	const char* GetDisplayName(const char* typeName) {
+		while (isdigit(static_cast<unsigned char>(*typeName))) {
+			typeName++;
+		}
+		return typeName;
+	}
+
+	// Nearest rank on an ascending range
+	float GetPercentile(const std::vector<float>& sortedValues, double fraction) {
+		if (sortedValues.empty()) {
+			return 0.0f;
+		}
+		size_t rank = static_cast<size_t>(fraction * sortedValues.size() + 0.5);
+		rank = std::min(std::max<size_t>(rank, 1), sortedValues.size());
+		return sortedValues[rank - 1];
+	}
+}
+
+PerformanceOverlay::PerformanceOverlay() {
+	isInitialized = false;
+	isVisible = false;
+	lastFrameTime = 0;
+	lastRefreshTime = 0;
+	p50Millis = 0.0f;
+	p95Millis = 0.0f;
+	p99Millis = 0.0f;
+	worstMillis = 0.0f;
+	numEntities = 0;
+	poolBytes = 0;
+	lastLogCount = 0;
+	logsPerSecond = 0.0;
+	logsDropped = 0;
+	overlayNanos = 0;
+	overlayAllocations = 0;
+}
+
+PerformanceOverlay::~PerformanceOverlay() {
+	Destroy();
+}
+
+void PerformanceOverlay::Initialize(SDL_Renderer* renderer, int width, int height) {
+	if (isInitialized || !renderer) {
+		return;
+	}
+
+	ImGui::CreateContext();
+	ImGuiIO& io = ImGui::GetIO();
+	io.IniFilename = nullptr;
+	ImGuiSDL::Initialize(renderer, width, height);
+
+	frameNanos.reserve(PERFORMANCE_OVERLAY_FRAMES);
+	frameMillis.reserve(PERFORMANCE_OVERLAY_FRAMES);
+	sortedMillis.reserve(PERFORMANCE_OVERLAY_FRAMES);
+
+	isInitialized = true;
+	LOG_INFO("Performance overlay ready, press F1 to show it");
+}
+
+void PerformanceOverlay::Destroy() {
+	if (!isInitialized) {
+		return;
+	}
+	ImGuiSDL::Deinitialize();
+	ImGui::DestroyContext();
+	isInitialized = false;
+	isVisible = false;
+}
+
+void PerformanceOverlay::Toggle() {
+	if (!isInitialized) {
+		return;
+	}
+	isVisible = !isVisible;
+
+	// Rates restart from the moment the overlay is shown
+	lastFrameTime = 0;
+	lastRefreshTime = 0;
+}
+
+bool PerformanceOverlay::IsVisible() const {
+	return isVisible;
+}
+
+void PerformanceOverlay::ProcessEvent(const SDL_Event& event) {
+	if (!isVisible) {
+		return;
+	}
+	if (event.type == SDL_MOUSEWHEEL) {
+		ImGui::GetIO().MouseWheel += static_cast<float>(event.wheel.y);
+	}
+}
+
+void PerformanceOverlay::Refresh(const Registry& registry, int64_t now) {
+	sortedMillis.assign(frameMillis.begin(), frameMillis.end());
+	std::sort(sortedMillis.begin(), sortedMillis.end());
+	p50Millis = GetPercentile(sortedMillis, 0.50);
+	p95Millis = GetPercentile(sortedMillis, 0.95);
+	p99Millis = GetPercentile(sortedMillis, 0.99);
+	worstMillis = sortedMillis.empty() ? 0.0f : sortedMillis.back();
+
+	Profiler::GetLastFrameScopes(scopes);
+
+	registry.GetSystemStats(systems);
+	std::sort(systems.begin(), systems.end(), [](const SystemStats& a, const SystemStats& b) {
+		return strcmp(GetDisplayName(a.name), GetDisplayName(b.name)) < 0;
+	});
+
+	registry.GetComponentPoolStats(pools);
+	poolBytes = 0;
+	for (const auto& pool: pools) {
+		poolBytes += pool.memoryBytes;
+	}
+	numEntities = registry.GetNumEntities();
+
+	const unsigned long long logCount = Logger::GetQueuedCount();
+	if (lastRefreshTime != 0) {
+		logsPerSecond = (logCount - lastLogCount) / ((now - lastRefreshTime) / 1e9);
+	}
+	lastLogCount = logCount;
+	logsDropped = Logger::GetDroppedCount();
+
+	frameAllocations = AllocationTracker::GetLastFrameStats();
+	processAllocations = AllocationTracker::GetLastFrameProcessStats();
+
+	lastRefreshTime = now;
+}
+
+void PerformanceOverlay::Draw() {
+	ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_Always);
+	ImGui::SetNextWindowBgAlpha(0.8f);
+	ImGui::Begin("Performance", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoMove);
+
+	const float lastMillis = frameMillis.empty() ? 0.0f : frameMillis.back();
+	ImGui::Text("Frame %.2f ms  p50 %.2f  p95 %.2f  p99 %.2f  max %.2f", lastMillis, p50Millis, p95Millis, p99Millis, worstMillis);
+	if (!frameMillis.empty()) {
+		ImGui::PlotLines("##FrameTimes", frameMillis.data(), static_cast<int>(frameMillis.size()), 0, nullptr,
+			0.0f, std::max(worstMillis, 1.0f) * 1.1f, ImVec2(360, 70));
+	}
+	ImGui::Text("Overlay %.3f ms", overlayNanos / 1e6);
+	if (AllocationTracker::IsEnabled()) {
+		ImGui::SameLine();
+		ImGui::Text(" %llu allocations", static_cast<unsigned long long>(overlayAllocations));
+	}
+
+	if (ImGui::CollapsingHeader("Scopes (last frame)", ImGuiTreeNodeFlags_DefaultOpen)) {
+		for (const auto& scope: scopes) {
+			const int indent = static_cast<int>(scope.depth) * 2;
+			ImGui::Text("%*s%-*s %8.3f ms %4u", indent, "", 32 - indent, scope.name,
+				scope.totalNanos / 1e6, scope.calls);
+		}
+	}
+
+	// Only PROFILER_PERF_COUNTERS builds fill these in
+	bool hasCounters = false;
+	for (const auto& scope: scopes) {
+		hasCounters = hasCounters || scope.hasCounters;
+	}
+	if (hasCounters && ImGui::CollapsingHeader("Hardware counters (last frame)", ImGuiTreeNodeFlags_DefaultOpen)) {
+		ImGui::Text("%-20s %10s %5s %9s %9s %9s", "", "kcycles", "IPC", "L1D miss", "LLC miss", "br miss");
+		for (const auto& scope: scopes) {
+			if (!scope.hasCounters) {
+				continue;
+			}
+			const uint64_t* values = scope.counters.values;
+			const double ipc = values[PERF_CYCLES] > 0 ? static_cast<double>(values[PERF_INSTRUCTIONS]) / values[PERF_CYCLES] : 0.0;
+			ImGui::Text("%-20s %10.1f %5.2f %9llu %9llu %9llu", scope.name, values[PERF_CYCLES] / 1000.0, ipc,
+				static_cast<unsigned long long>(values[PERF_L1D_MISSES]),
+				static_cast<unsigned long long>(values[PERF_LLC_MISSES]),
+				static_cast<unsigned long long>(values[PERF_BRANCH_MISSES]));
+		}
+	}
+
+	if (ImGui::CollapsingHeader("Systems", ImGuiTreeNodeFlags_DefaultOpen)) {
+		ImGui::Text("Entities alive %d", numEntities);
+		for (const auto& system: systems) {
+			ImGui::Text("%-24s %8zu", GetDisplayName(system.name), system.numEntities);
+		}
+	}
+
+	if (ImGui::CollapsingHeader("Component pools")) {
+		for (const auto& pool: pools) {
+			ImGui::Text("%-24s %8d %10.1f KiB", GetDisplayName(pool.name), pool.size, pool.memoryBytes / 1024.0);
+		}
+		ImGui::Text("%-24s %8s %10.1f KiB", "Total", "", poolBytes / 1024.0);
+	}
+
+	if (ImGui::CollapsingHeader("Memory and logging", ImGuiTreeNodeFlags_DefaultOpen)) {
+		if (AllocationTracker::IsEnabled()) {
+			ImGui::Text("Allocations/frame  %llu (%llu bytes)", static_cast<unsigned long long>(frameAllocations.allocations),
+				static_cast<unsigned long long>(frameAllocations.allocatedBytes));
+			ImGui::Text("All threads/frame  %llu", static_cast<unsigned long long>(processAllocations.allocations));
+		} else {
+			ImGui::Text("Allocations/frame  not tracked, build with ALLOC_TRACKING=1");
+		}
+		ImGui::Text("Log messages/s     %.1f", logsPerSecond);
+		ImGui::Text("Log messages lost  %llu", logsDropped);
+	}
+
+	ImGui::End();
+}
+
+void PerformanceOverlay::Render(const Registry& registry) {
+	if (!isVisible) {
+		return;
+	}
+
+	PROFILE_SCOPE("PerformanceOverlay::Render");
+	const int64_t start = Profiler::Now();
+	const uint64_t startAllocations = AllocationTracker::GetThreadStats().allocations;
+
+	Profiler::GetFrameTimes(frameNanos, PERFORMANCE_OVERLAY_FRAMES);
+	frameMillis.resize(frameNanos.size());
+	for (size_t i = 0; i < frameNanos.size(); i++) {
+		frameMillis[i] = frameNanos[i] / 1e6f;
+	}
+
+	if (lastRefreshTime == 0 || (start - lastRefreshTime) / 1e9 >= PERFORMANCE_OVERLAY_REFRESH_SECONDS) {
+		Refresh(registry, start);
+	}
+
+	ImGuiIO& io = ImGui::GetIO();
+	io.DeltaTime = lastFrameTime != 0 ? std::max((start - lastFrameTime) / 1e9f, 1e-6f) : 1.0f / 60.0f;
+	lastFrameTime = start;
+
+	int mouseX, mouseY;
+	const Uint32 buttons = SDL_GetMouseState(&mouseX, &mouseY);
+	io.MousePos = ImVec2(static_cast<float>(mouseX), static_cast<float>(mouseY));
+	io.MouseDown[0] = (buttons & SDL_BUTTON(SDL_BUTTON_LEFT)) != 0;
+	io.MouseDown[1] = (buttons & SDL_BUTTON(SDL_BUTTON_RIGHT)) != 0;
+
+	ImGui::NewFrame();
+	Draw();
+	ImGui::Render();
+	ImGuiSDL::Render(ImGui::GetDrawData());
+
+	overlayNanos = Profiler::Now() - start;
+	overlayAllocations = AllocationTracker::GetThreadStats().allocations - startAllocations;
+}
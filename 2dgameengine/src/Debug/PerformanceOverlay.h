@@ -0,0 +1,75 @@
+#ifndef PERFORMANCEOVERLAY_H
+#define PERFORMANCEOVERLAY_H
+
+#include "../ECS/ECS.h"
+#include "../Profiler/Profiler.h"
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <vector>
+
+// Frames shown in the frame time graph
+const size_t PERFORMANCE_OVERLAY_FRAMES = 240;
+
+// Percentiles, tables and rates are recomputed this often instead of every frame
+const double PERFORMANCE_OVERLAY_REFRESH_SECONDS = 0.25;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PerformanceOverlay: ImGui window drawn over the game with frame time percentiles, per scope timings, entities
+// per system, pool memory and log throughput. Everything is read from the engine's own counters, and nothing
+// runs while the overlay is hidden.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class PerformanceOverlay {
+	private:
+		bool isInitialized;
+		bool isVisible;
+		int64_t lastFrameTime;
+		int64_t lastRefreshTime;
+
+		// Frame graph, refreshed every frame from the profiler's frame ring
+		std::vector<int64_t> frameNanos;
+		std::vector<float> frameMillis;
+
+		// Snapshot taken at each refresh
+		std::vector<float> sortedMillis;
+		float p50Millis;
+		float p95Millis;
+		float p99Millis;
+		float worstMillis;
+		std::vector<ProfileScopeTotal> scopes;
+		std::vector<SystemStats> systems;
+		std::vector<ComponentPoolStats> pools;
+		int numEntities;
+		size_t poolBytes;
+		unsigned long long lastLogCount;
+		double logsPerSecond;
+		unsigned long long logsDropped;
+		AllocationStats frameAllocations;
+		AllocationStats processAllocations;
+
+		// What the overlay itself cost on the previous frame, so its skew stays visible
+		int64_t overlayNanos;
+		uint64_t overlayAllocations;
+
+		void Refresh(const Registry& registry, int64_t now);
+		void Draw();
+
+	public:
+		PerformanceOverlay();
+		~PerformanceOverlay();
+
+		// Needs a renderer, the overlay stays unavailable in pure headless runs
+		void Initialize(SDL_Renderer* renderer, int width, int height);
+		void Destroy();
+
+		void Toggle();
+		bool IsVisible() const;
+
+		// Forwards the input ImGui can't poll for itself, mouse wheel only for now
+		void ProcessEvent(const SDL_Event& event);
+
+		// Builds and draws the overlay on the current render target, call before presenting
+		void Render(const Registry& registry);
+};
+
+#endif
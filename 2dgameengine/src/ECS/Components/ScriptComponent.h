@@ -0,0 +1,31 @@
+#ifndef SCRIPTCOMPONENT_H
+#define SCRIPTCOMPONENT_H
+
+#include "../../Scripting/ComponentViews.h"
+#include <sol/sol.hpp>
+
+struct ScriptComponent {
+	// Resolved once when the script is attached, calling it is a registry lookup by reference
+	sol::protected_function update;
+
+	// The entity as Lua userdata, made on the first call and passed on every one after,
+	// so calls don't allocate a fresh handle each frame
+	sol::object self;
+
+	// Component proxies handed out by entity.transform and friends, made on first access
+	sol::object proxies[PROXY_TYPE_COUNT];
+
+	// Index of the ScriptSystem batch whose update_all runs this entity, -1 for per-entity update calls
+	int batch;
+
+	// Index of the ScriptWorkerPool group that runs this entity on the worker threads, -1 when it runs on the main state
+	int parallelGroup;
+
+	ScriptComponent(sol::protected_function update = sol::lua_nil, int batch = -1, int parallelGroup = -1) {
+		this->update = update;
+		this->batch = batch;
+		this->parallelGroup = parallelGroup;
+	}
+};
+
+#endif
@@ -9,13 +9,27 @@ struct TransformComponent {
 	glm::vec2 scale;
 	double rotation;
 
+	// State at the start of the last simulation step, rendering interpolates from here
+	glm::vec2 previousPosition;
+	double previousRotation;
+
 	TransformComponent(glm::vec2 position = glm::vec2(0, 0), glm::vec2 scale = glm::vec2(1, 1), double rotation = 0.0) {
 		this->position = position;
 		this->scale = scale;
 		this->rotation = rotation;
+		this->previousPosition = position;
+		this->previousRotation = rotation;
+	}
+
+	glm::vec2 GetInterpolatedPosition(double alpha) const {
+		return glm::mix(previousPosition, position, static_cast<float>(alpha));
+	}
+
+	double GetInterpolatedRotation(double alpha) const {
+		return previousRotation + (rotation - previousRotation) * alpha;
 	}
 };
 
 
 
-#endif
\ No newline at end of file
+#endif
@@ -1,5 +1,6 @@
 #include "ECS.h"
 #include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
 #include <string>
 
 int IComponent::nextId = 0;
@@ -12,51 +13,106 @@ int Entity::GetId() const {
 
 
 void System::AddEntityToSystem(Entity entity){
+	const auto entityId = entity.GetId();
+	if (entityId >= static_cast<int>(entityIndices.size())) {
+		entityIndices.resize(entityId + 1, -1);
+	}
+	if (entityIndices[entityId] != -1) {
+		return;
+	}
+
+	entityIndices[entityId] = static_cast<int>(entities.size());
 	entities.push_back(entity);
 }
 
 
 
 void System::RemoveEntityFromSystem(Entity entity){
-	// Using c++ iterators
-	entities.erase(std::__remove_if(entities.begin(), entities.end(),
-		[&entity](Entity other){
-			return entity == other;
-		}), entities.end());
+	const auto entityId = entity.GetId();
+	if (entityId >= static_cast<int>(entityIndices.size()) || entityIndices[entityId] == -1) {
+		return;
+	}
+
+	// Move the last entity into the hole
+	const int index = entityIndices[entityId];
+	const Entity last = entities.back();
+	entities[index] = last;
+	entityIndices[last.GetId()] = index;
+
+	entities.pop_back();
+	entityIndices[entityId] = -1;
 }
 
 
 
-std::vector<Entity> System::GetSystemEntities() const{
+bool System::HasEntity(int entityId) const {
+	return entityId >= 0 && entityId < static_cast<int>(entityIndices.size()) && entityIndices[entityId] != -1;
+}
+
+
+
+const std::vector<Entity>& System::GetSystemEntities() const{
 	return entities;
 }
 
 
+size_t System::GetNumEntities() const {
+	return entities.size();
+}
+
+
 const Signature& System::GetComponentSignature() const {
 	return componentSignature;
 }
 
 
 
+Registry::~Registry() {
+	for (auto pool: componentPools) {
+		delete pool;
+	}
+	for (auto& system: systems) {
+		delete system.second;
+	}
+}
+
+
+
 Entity Registry::CreateEntity() {
-	int entityId;
-	
-	entityId = numEntities++;
+	const int entityId = numEntities++;
 
 	Entity entity(entityId);
+	entity.registry = this;
 	entitiesToBeAdded.insert(entity);
 
-	if (entityId >= entityComponentSignatures.size()) {
+	if (entityId >= static_cast<int>(entityComponentSignatures.size())) {
 		entityComponentSignatures.resize(entityId + 1);
+		entityIsAlive.resize(entityId + 1, false);
 	}
+	entityIsAlive[entityId] = true;
 
-	Logger::Log("Entity created with id = " + std::to_string(entityId));
+	LOG_DEBUG("Entity created with id = %d", entityId);
 
 	return entity;
 }
 
 
 
+void Registry::KillEntity(Entity entity) {
+	if (!IsEntityAlive(entity.GetId())) {
+		return;
+	}
+	entitiesToBeRemoved.insert(entity);
+}
+
+
+
+bool Registry::IsEntityAlive(int entityId) const {
+	return entityId >= 0 && entityId < static_cast<int>(entityIsAlive.size()) && entityIsAlive[entityId];
+}
+
+
+
 void Registry::AddEntityToSystems(Entity entity){
 	const auto entityId = entity.GetId();
 	const auto& entityComponentSignature = entityComponentSignatures[entityId];
@@ -75,10 +131,57 @@ void Registry::AddEntityToSystems(Entity entity){
 
 
 
+void Registry::RemoveEntityFromSystems(Entity entity){
+	for (auto& system: systems){
+		system.second->RemoveEntityFromSystem(entity);
+	}
+}
+
+
+
+
 void Registry::Update() {
+	PROFILE_SCOPE("Registry::Update");
+
 	for (auto entity: entitiesToBeAdded){
 		AddEntityToSystems(entity);
 	}
 
 	entitiesToBeAdded.clear();
-}
\ No newline at end of file
+
+	for (auto entity: entitiesToBeRemoved){
+		RemoveEntityFromSystems(entity);
+
+		// Components stay in their pools, the cleared signature is what marks them unused
+		entityComponentSignatures[entity.GetId()].reset();
+		entityIsAlive[entity.GetId()] = false;
+		numRemovedEntities++;
+	}
+
+	entitiesToBeRemoved.clear();
+}
+
+
+int Registry::GetNumEntities() const {
+	return numEntities - numRemovedEntities;
+}
+
+
+
+void Registry::GetSystemStats(std::vector<SystemStats>& stats) const {
+	stats.clear();
+	for (auto& system: systems) {
+		stats.push_back({system.first.name(), system.second->GetNumEntities()});
+	}
+}
+
+
+
+void Registry::GetComponentPoolStats(std::vector<ComponentPoolStats>& stats) const {
+	stats.clear();
+	for (auto pool: componentPools) {
+		if (pool) {
+			stats.push_back({pool->GetTypeName(), pool->GetSize(), pool->GetMemoryUsage()});
+		}
+	}
+}
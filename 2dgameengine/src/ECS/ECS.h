@@ -20,6 +20,18 @@ const unsigned int MAX_COMPONENTS = 32;
 
 typedef std::bitset<MAX_COMPONENTS> Signature;
 
+// Snapshots handed to debug tools, names are the compiler's type names
+struct SystemStats {
+	const char* name;
+	size_t numEntities;
+};
+
+struct ComponentPoolStats {
+	const char* name;
+	int size;
+	size_t memoryBytes;
+};
+
 struct IComponent {
 	protected:
 		static int nextId;
@@ -35,9 +47,17 @@ class Entity {
 		int id;
 
 	public:
-		Entity(int id): id(id) {}; // Syntax used to automatically initialize constructor
+		Entity(int id): id(id), registry(nullptr) {}; // Syntax used to automatically initialize constructor
 		int GetId() const;
 
+		// Registry that owns this entity, used by the component helpers below
+		class Registry* registry;
+
+		template <typename TComponent, typename ...TArgs> void AddComponent(TArgs&& ...args);
+		template <typename TComponent> void RemoveComponent();
+		template <typename TComponent> bool HasComponent() const;
+		template <typename TComponent> TComponent& GetComponent() const;
+
 		// Testing operator overloading
 		Entity& operator = (const Entity& other) = default;
 		bool operator == (const Entity& other) const {return id == other.id;}
@@ -53,6 +73,7 @@ class Entity {
 
 template <typename T>
 class Component: public IComponent {
+	public:
 	// Returns the unique id of Component<T>
 	static int GetId(){
 		static auto id = nextId++;
@@ -70,13 +91,21 @@ class System {
 		Signature componentSignature;
 		std::vector<Entity> entities;
 
+		// Position of each entity in entities, -1 when absent, so removal is a swap with the last one
+		// [Vector index = entity id]
+		std::vector<int> entityIndices;
+
 	public:
 		System() = default;
-		~System() = default;
-
-		void AddEntityToSystem(Entity entity);
-		void RemoveEntityFromSystem(Entity entity);	
-		std::vector<Entity> GetSystemEntities() const;
+		virtual ~System() = default;
+
+		// Systems holding per-entity state override these to set it up and drop it. The order of the
+		// remaining entities is not kept on removal
+		virtual void AddEntityToSystem(Entity entity);
+		virtual void RemoveEntityFromSystem(Entity entity);
+		bool HasEntity(int entityId) const;
+		const std::vector<Entity>& GetSystemEntities() const;
+		size_t GetNumEntities() const;
 		const Signature& GetComponentSignature() const;
 
         // Define the components an entity must have
@@ -90,11 +119,14 @@ class System {
 class IPool {
 	public:
 		virtual ~IPool() {}
+		virtual int GetSize() const = 0;
+		virtual size_t GetMemoryUsage() const = 0;
+		virtual const char* GetTypeName() const = 0;
 };
 
 
 template <typename T>
-class Pool: IPool {
+class Pool: public IPool {
 	private:
 		std::vector<T> data;
 
@@ -110,10 +142,19 @@ class Pool: IPool {
 			return data.empty();
 		}
 
-		int GetSize() const {
+		int GetSize() const override {
 			return data.size();
 		}
 
+		// Bytes reserved for component data, including unused capacity
+		size_t GetMemoryUsage() const override {
+			return data.capacity() * sizeof(T);
+		}
+
+		const char* GetTypeName() const override {
+			return typeid(T).name();
+		}
+
 		void Resize(int n) {
 			data.resize(n);
 		}
@@ -156,20 +197,37 @@ class Registry {
 		// [Vector index = entity id]
 		std::vector<Signature> entityComponentSignatures;
 
+		// Whether the id belongs to a created entity that hasn't been removed yet, a cleared signature can't
+		// tell since live entities may have no components
+		// [Vector index = entity id]
+		std::vector<bool> entityIsAlive;
+
 		std::unordered_map<std::type_index, System*> systems;
 
 		// Set of entities that are flagged to be added/removed in next registry update
 		std::set<Entity> entitiesToBeAdded;
 		std::set<Entity> entitiesToBeRemoved;
 
+		// Killed entities whose removal Update has applied. Their ids are never handed out again, so an id
+		// kept by a script, a message or a proxy can't come to name a different entity
+		int numRemovedEntities = 0;
+
 	public:
 		Registry() = default;
+		~Registry();
 
 		// TODO:
 		void Update();
 
 		Entity CreateEntity();
 
+		// Flags the entity, it leaves its systems on the next Update. Ids that aren't alive are ignored, so a
+		// stale handle can't remove an entity twice
+		void KillEntity(Entity entity);
+
+		// False for ids never handed out and for ids already removed by Update
+		bool IsEntityAlive(int entityId) const;
+
 
 		void AddEntityToSystem();
 
@@ -177,7 +235,9 @@ class Registry {
 
 		template <typename T> void RemoveComponent(Entity entity);
 
-		template <typename T> bool HasComponent(Entity entity);
+		template <typename T> bool HasComponent(Entity entity) const;
+
+		template <typename T> T& GetComponent(Entity entity) const;
 
 		
 		
@@ -188,7 +248,15 @@ class Registry {
 
 		// Checks the component signature of an entity and adds it to systems that are interested
 		void AddEntityToSystems(Entity entity);
-		
+		void RemoveEntityFromSystems(Entity entity);
+
+		// Entities created and not yet killed
+		int GetNumEntities() const;
+
+		// Filled on demand by debug tools, vectors are reused so steady state polling doesn't allocate
+		void GetSystemStats(std::vector<SystemStats>& stats) const;
+		void GetComponentPoolStats(std::vector<ComponentPoolStats>& stats) const;
+
 };
 
 
@@ -201,7 +269,10 @@ void Registry::AddSystem(TArgs&& ...args) {
 template <typename TSystem>
 void Registry::RemoveSystem(){
 	auto system = systems.find(std::type_index(typeid(TSystem)));
-	systems.erase(system);
+	if (system != systems.end()) {
+		delete system->second;
+		systems.erase(system);
+	}
 }
 
 template <typename TSystem>
@@ -214,7 +285,7 @@ TSystem& Registry::GetSystem() const {
 	auto system = systems.find(std::type_index(typeid(TSystem)));
 
 	// Don't use '.' when working with pointer use -> instead //
-	return *(std::static_pointer_cast<TSystem>(system->second));
+	return *(static_cast<TSystem*>(system->second));
 }
 
 
@@ -233,7 +304,7 @@ void Registry::AddComponent(Entity entity, TArgs&& ...args) {
 
 	// If 
 
-	if (componentId >= componentPools.size()) {
+	if (componentId >= static_cast<int>(componentPools.size())) {
 		componentPools.resize(componentId + 1, nullptr);
 	}
 
@@ -242,7 +313,7 @@ void Registry::AddComponent(Entity entity, TArgs&& ...args) {
 		componentPools[componentId] = newComponentPool;
 	}
 
-	Pool<TComponent>* componentPool = componentPools[componentId];
+	Pool<TComponent>* componentPool = static_cast<Pool<TComponent>*>(componentPools[componentId]);
 
 	if (entityId >= componentPool->GetSize()) {
 		componentPool->Resize(numEntities);
@@ -263,11 +334,40 @@ void Registry::RemoveComponent(Entity entity) {
 }
 
 template <typename T>
-bool Registry::HasComponent(Entity entity) {
+bool Registry::HasComponent(Entity entity) const {
 	const auto componentId = Component<T>::GetId();
 	const auto entityId = entity.GetId();
 
 	return entityComponentSignatures[entityId].test(componentId);
 }
 
+template <typename T>
+T& Registry::GetComponent(Entity entity) const {
+	const auto componentId = Component<T>::GetId();
+	const auto entityId = entity.GetId();
+
+	auto componentPool = static_cast<Pool<T>*>(componentPools[componentId]);
+	return componentPool->Get(entityId);
+}
+
+template <typename TComponent, typename ...TArgs>
+void Entity::AddComponent(TArgs&& ...args) {
+	registry->AddComponent<TComponent>(*this, std::forward<TArgs>(args)...);
+}
+
+template <typename TComponent>
+void Entity::RemoveComponent() {
+	registry->RemoveComponent<TComponent>(*this);
+}
+
+template <typename TComponent>
+bool Entity::HasComponent() const {
+	return registry->HasComponent<TComponent>(*this);
+}
+
+template <typename TComponent>
+TComponent& Entity::GetComponent() const {
+	return registry->GetComponent<TComponent>(*this);
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,42 @@
+#ifndef ANIMATIONSYSTEM_H
+#define ANIMATIONSYSTEM_H
+
+#include "../ECS.h"
+#include "../../Profiler/Profiler.h"
+#include "../Components/SpriteComponent.h"
+#include "../Components/AnimationComponent.h"
+#include <SDL2/SDL.h>
+#include <vector>
+
+class AnimationSystem: public System {
+	public:
+		AnimationSystem() {
+			RequireComponent<SpriteComponent>();
+			RequireComponent<AnimationComponent>();
+		}
+
+		// Frames are derived from the elapsed time, so skipping entities while they are
+		// off-screen never puts them out of step
+		void Update(const std::vector<Entity>& visibleEntities) {
+			PROFILE_SYSTEM("AnimationSystem");
+
+			for (auto entity: visibleEntities) {
+				if (!entity.HasComponent<AnimationComponent>()) {
+					continue;
+				}
+
+				auto& animation = entity.GetComponent<AnimationComponent>();
+				auto& sprite = entity.GetComponent<SpriteComponent>();
+
+				int frame = (SDL_GetTicks() - animation.startTime) * animation.frameSpeedRate / 1000;
+				if (animation.isLoop) {
+					animation.currentFrame = frame % animation.numFrames;
+				} else {
+					animation.currentFrame = frame < animation.numFrames ? frame : animation.numFrames - 1;
+				}
+				sprite.srcRect.x = animation.currentFrame * sprite.width;
+			}
+		}
+};
+
+#endif
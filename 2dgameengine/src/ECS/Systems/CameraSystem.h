@@ -0,0 +1,123 @@
+#ifndef CAMERASYSTEM_H
+#define CAMERASYSTEM_H
+
+#include "../ECS.h"
+#include "../../Profiler/Profiler.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/SpriteComponent.h"
+#include "../../Spatial/SpatialGrid.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// CameraSystem: Owns the view rectangle and a spatial index of every drawable entity.
+// Each frame it collects the entities that intersect the view so that the render and
+// animation systems never look at what is off-screen.
+//
+// Entities are indexed when they join the system. After that only the ids appended to
+// GetMovedEntityIds are re-indexed, so code that writes a TransformComponent outside the
+// setup of a new entity must report it there (MovementSystem and the script bindings do).
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class CameraSystem: public System {
+	private:
+		SDL_Rect view;
+		SpatialGrid spatialGrid;
+		std::vector<int> movedEntityIds;
+		std::vector<int> visibleIds;
+		std::vector<Entity> visibleEntities;
+		Registry* registry;
+
+		void IndexEntity(const Entity& entity) {
+			const auto& transform = entity.GetComponent<TransformComponent>();
+			const auto& sprite = entity.GetComponent<SpriteComponent>();
+
+			spatialGrid.Update(
+				entity.GetId(),
+				transform.position.x,
+				transform.position.y,
+				sprite.width * transform.scale.x,
+				sprite.height * transform.scale.y
+			);
+		}
+
+	public:
+		CameraSystem(int viewWidth, int viewHeight, int cellSize = 128): spatialGrid(cellSize), registry(nullptr) {
+			RequireComponent<TransformComponent>();
+			RequireComponent<SpriteComponent>();
+			view = {0, 0, viewWidth, viewHeight};
+		}
+
+		const SDL_Rect& GetView() const {
+			return view;
+		}
+
+		void SetPosition(int x, int y) {
+			view.x = x;
+			view.y = y;
+		}
+
+		void SetSize(int width, int height) {
+			view.w = width;
+			view.h = height;
+		}
+
+		// Keeps the view inside a world of the given size, e.g. the tilemap
+		void ClampToBounds(int worldWidth, int worldHeight) {
+			view.x = std::max(0, std::min(view.x, worldWidth - view.w));
+			view.y = std::max(0, std::min(view.y, worldHeight - view.h));
+		}
+
+		const std::vector<Entity>& GetVisibleEntities() const {
+			return visibleEntities;
+		}
+
+		// Ids of entities whose transform changed since the last Update. Duplicates and ids of entities
+		// outside the system are fine, they cost a compare
+		std::vector<int>& GetMovedEntityIds() {
+			return movedEntityIds;
+		}
+
+		void AddEntityToSystem(Entity entity) override {
+			if (HasEntity(entity.GetId())) {
+				return;
+			}
+			System::AddEntityToSystem(entity);
+			IndexEntity(entity);
+			registry = entity.registry;
+		}
+
+		void RemoveEntityFromSystem(Entity entity) override {
+			System::RemoveEntityFromSystem(entity);
+			spatialGrid.Remove(entity.GetId());
+		}
+
+		void Update() {
+			PROFILE_SYSTEM("CameraSystem");
+
+			// Entities whose covered cells did not change cost a compare
+			for (int entityId: movedEntityIds) {
+				if (HasEntity(entityId)) {
+					Entity entity(entityId);
+					entity.registry = registry;
+					IndexEntity(entity);
+				}
+			}
+			movedEntityIds.clear();
+
+			visibleIds.clear();
+			visibleEntities.clear();
+			spatialGrid.Query(view.x, view.y, view.w, view.h, visibleIds);
+
+			// Keep a stable draw order no matter which cells the ids came from
+			std::sort(visibleIds.begin(), visibleIds.end());
+			for (int entityId: visibleIds) {
+				Entity entity(entityId);
+				entity.registry = registry;
+				visibleEntities.push_back(entity);
+			}
+		}
+};
+
+#endif
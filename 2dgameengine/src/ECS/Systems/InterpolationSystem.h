@@ -0,0 +1,32 @@
+#ifndef INTERPOLATIONSYSTEM_H
+#define INTERPOLATIONSYSTEM_H
+
+#include "../ECS.h"
+#include "../../Profiler/Profiler.h"
+#include "../Components/TransformComponent.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// InterpolationSystem: Saves the state every transform starts a fixed simulation step with, which rendering
+// interpolates from. Runs first in the step, so whatever moves an entity afterwards, a rigid body or a script,
+// is blended in rather than snapped to.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class InterpolationSystem: public System {
+	public:
+		InterpolationSystem() {
+			RequireComponent<TransformComponent>();
+		}
+
+		// Runs once per fixed simulation step, before anything that writes transforms
+		void Update() {
+			PROFILE_SYSTEM("InterpolationSystem");
+
+			for (const auto& entity: GetSystemEntities()) {
+				auto& transform = entity.GetComponent<TransformComponent>();
+				transform.previousPosition = transform.position;
+				transform.previousRotation = transform.rotation;
+			}
+		}
+};
+
+#endif
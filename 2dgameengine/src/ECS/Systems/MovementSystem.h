@@ -1,20 +1,43 @@
 #ifndef MOVEMENTSYSTEM_H
 #define MOVEMENTSYSTEM_H
 
-class MovementSystem {
+#include "../ECS.h"
+#include "../../Profiler/Profiler.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/RigidBodyComponent.h"
+#include <vector>
+
+class MovementSystem: public System {
+private:
+	std::vector<int>* movedEntityIds = nullptr;
+
 public:
 	MovementSystem(){
-		//TODO: RequireComponent<TransformComponent>();
-		//...
+		RequireComponent<TransformComponent>();
+		RequireComponent<RigidBodyComponent>();
+	}
+
+	// Entities that actually move are appended here, e.g. CameraSystem::GetMovedEntityIds
+	void SetMovedEntityIds(std::vector<int>* movedEntityIds) {
+		this->movedEntityIds = movedEntityIds;
 	}
 
-	void Update(){
-		//TODO:
-		// Loop all entities the system is interested in
-		//for(auto entity: GetEntities()) {
-			//Update entity position based on it's velocity
-		//}
+	// Runs once per fixed simulation step
+	void Update(double deltaTime){
+		PROFILE_SYSTEM("MovementSystem");
+
+		for (const auto& entity: GetSystemEntities()) {
+			auto& transform = entity.GetComponent<TransformComponent>();
+			const auto& rigidBody = entity.GetComponent<RigidBodyComponent>();
+
+			transform.position.x += rigidBody.velocity.x * deltaTime;
+			transform.position.y += rigidBody.velocity.y * deltaTime;
+
+			if (movedEntityIds && (rigidBody.velocity.x != 0 || rigidBody.velocity.y != 0)) {
+				movedEntityIds->push_back(entity.GetId());
+			}
+		}
 	}
 };
 
-#endif
\ No newline at end of file
+#endif
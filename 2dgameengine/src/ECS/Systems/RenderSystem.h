@@ -0,0 +1,50 @@
+#ifndef RENDERSYSTEM_H
+#define RENDERSYSTEM_H
+
+#include "../ECS.h"
+#include "../../Profiler/Profiler.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/SpriteComponent.h"
+#include "../../AssetStore/AssetStore.h"
+#include <SDL2/SDL.h>
+#include <vector>
+
+class RenderSystem: public System {
+	public:
+		RenderSystem() {
+			RequireComponent<TransformComponent>();
+			RequireComponent<SpriteComponent>();
+		}
+
+		// Draws only the entities the camera reported as visible, alpha blends between the
+		// last two simulation states
+		void Update(SDL_Renderer* renderer, const AssetStore* assetStore, const SDL_Rect& camera, const std::vector<Entity>& visibleEntities, double alpha) {
+			PROFILE_SYSTEM("RenderSystem");
+
+			for (auto entity: visibleEntities) {
+				const auto& transform = entity.GetComponent<TransformComponent>();
+				const auto& sprite = entity.GetComponent<SpriteComponent>();
+
+				glm::vec2 position = transform.GetInterpolatedPosition(alpha);
+
+				SDL_Rect dstRect = {
+					static_cast<int>(position.x - camera.x),
+					static_cast<int>(position.y - camera.y),
+					static_cast<int>(sprite.width * transform.scale.x),
+					static_cast<int>(sprite.height * transform.scale.y)
+				};
+
+				SDL_RenderCopyEx(
+					renderer,
+					assetStore->GetTexture(sprite.assetId),
+					&sprite.srcRect,
+					&dstRect,
+					transform.GetInterpolatedRotation(alpha),
+					NULL,
+					SDL_FLIP_NONE
+				);
+			}
+		}
+};
+
+#endif
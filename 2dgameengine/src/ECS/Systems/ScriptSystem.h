@@ -0,0 +1,289 @@
+#ifndef SCRIPTSYSTEM_H
+#define SCRIPTSYSTEM_H
+
+#include "../ECS.h"
+#include "../../Logger/Logger.h"
+#include "../../Profiler/Profiler.h"
+#include "../../Scripting/ComponentViews.h"
+#include "../../Scripting/ScriptCache.h"
+#include "../../Scripting/ScriptScheduler.h"
+#include "../../Scripting/ScriptWorkerPool.h"
+#include "../Components/ScriptComponent.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/RigidBodyComponent.h"
+#include <sol/sol.hpp>
+#include <deque>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ScriptSystem: Runs the Lua scripts of every entity with a ScriptComponent, once per fixed simulation step.
+// A script file returns either its update function, called once per entity:
+//
+//   return function(entity, deltaTime)
+//       local transform = entity.transform
+//       transform.position_x = transform.position_x + 10 * deltaTime
+//   end
+//
+// or a table with update_all, called once per step with every entity using the script (see ComponentViews):
+//
+//   return {
+//       update_all = function(entities, deltaTime)
+//           local x = entities.position_x
+//           for i = 1, #entities do
+//               x[i] = x[i] + 10 * deltaTime
+//           end
+//       end
+//   }
+//
+// Each file runs once, however many entities use it, and is compiled only when it isn't in the ScriptCache.
+// Neither path does global lookups or uses string keys per entity, and batches pay the C++ to Lua transition
+// once for all of their entities.
+//
+// Batches that also set parallel = true run on the ScriptWorkerPool when it has workers, and as ordinary
+// batches otherwise. Every state gets post_message(topic, entityId, value), delivered to on_message in all
+// states on the next step, which is the only way scripts in different states talk to each other.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class ScriptSystem: public System {
+	private:
+		struct ScriptBatch {
+			std::string filePath;
+			sol::protected_function updateAll;
+			// Refilled every step, the view reads it in place
+			std::vector<Entity> entities;
+			sol::object view;
+		};
+
+		sol::state_view lua;
+		ScriptCache scriptCache;
+		ScriptWorkerPool workerPool;
+		std::vector<int>* movedEntityIds;
+		ScriptScheduler* scheduler;
+
+		// Components to attach by file path
+		std::unordered_map<std::string, ScriptComponent> scripts;
+
+		// A deque so the views keep pointing at the same entity lists as batches are added
+		std::deque<ScriptBatch> batches;
+
+		// Proxies are cached on the entity's ScriptComponent, so touching them every step allocates nothing
+		static sol::object GetProxy(Entity& entity, ComponentProxyType type, lua_State* L) {
+			if (!entity.HasComponent<ScriptComponent>()) {
+				return ComponentViews::CreateProxy(L, entity, type);
+			}
+			sol::object& proxy = entity.GetComponent<ScriptComponent>().proxies[type];
+			if (!proxy.valid()) {
+				proxy = ComponentViews::CreateProxy(L, entity, type);
+			}
+			return proxy;
+		}
+
+	public:
+		ScriptSystem(sol::state_view lua): lua(lua), movedEntityIds(nullptr), scheduler(nullptr) {
+			RequireComponent<ScriptComponent>();
+			CreateLuaBindings();
+		}
+
+		void CreateLuaBindings() {
+			ComponentViews::Register(lua.lua_state());
+
+			lua.new_usertype<Entity>(
+				"entity",
+				sol::no_constructor,
+				"get_id", &Entity::GetId,
+				"kill", [](Entity& entity) { entity.registry->KillEntity(entity); },
+				"transform", sol::readonly_property([](Entity& entity, sol::this_state state) {
+					return GetProxy(entity, PROXY_TRANSFORM, state);
+				}),
+				"rigid_body", sol::readonly_property([](Entity& entity, sol::this_state state) {
+					return GetProxy(entity, PROXY_RIGID_BODY, state);
+				})
+			);
+
+			lua.set_function("get_position", [](Entity& entity) {
+				const auto& transform = entity.GetComponent<TransformComponent>();
+				return std::make_tuple(transform.position.x, transform.position.y);
+			});
+			lua.set_function("set_position", [this](Entity& entity, float x, float y) {
+				auto& transform = entity.GetComponent<TransformComponent>();
+				transform.position.x = x;
+				transform.position.y = y;
+				if (movedEntityIds) {
+					movedEntityIds->push_back(entity.GetId());
+				}
+			});
+			lua.set_function("get_velocity", [](Entity& entity) {
+				const auto& rigidBody = entity.GetComponent<RigidBodyComponent>();
+				return std::make_tuple(rigidBody.velocity.x, rigidBody.velocity.y);
+			});
+			lua.set_function("set_velocity", [](Entity& entity, float x, float y) {
+				auto& rigidBody = entity.GetComponent<RigidBodyComponent>();
+				rigidBody.velocity.x = x;
+				rigidBody.velocity.y = y;
+			});
+			lua.set_function("post_message", [this](const std::string& topic, int entityId, double value) {
+				workerPool.PostMessage(topic, entityId, value);
+			});
+
+			// Same globals as the worker states, so parallel scripts also run here when there are no workers
+			lua.set_function("kill", [this](int entityId) {
+				workerPool.KillEntity(entityId);
+			});
+			lua["worker_index"] = 0;
+		}
+
+		ScriptCache& GetScriptCache() {
+			return scriptCache;
+		}
+
+		// Entities whose transform a script writes, in any state, are appended here (see
+		// CameraSystem::GetMovedEntityIds). Set it before loading scripts and after starting the worker pool
+		void SetMovedEntityIds(std::vector<int>* movedEntityIds) {
+			this->movedEntityIds = movedEntityIds;
+			ComponentViews::SetMovedEntityIds(lua.lua_state(), movedEntityIds);
+			workerPool.SetMovedEntityIds(movedEntityIds);
+		}
+
+		// Coroutines an entity's update function starts become its own and are cancelled when it's removed
+		void SetScheduler(ScriptScheduler* scheduler) {
+			this->scheduler = scheduler;
+		}
+
+		void RemoveEntityFromSystem(Entity entity) override {
+			System::RemoveEntityFromSystem(entity);
+			if (scheduler) {
+				scheduler->CancelOwnedBy(entity.GetId());
+			}
+		}
+
+		// Start it before loading scripts, parallel scripts loaded earlier stay on the main state
+		ScriptWorkerPool& GetWorkerPool() {
+			return workerPool;
+		}
+
+		// Runs the file on first use and returns the component that attaches it, one without an update
+		// function on error
+		ScriptComponent LoadScript(const std::string& filePath) {
+			auto script = scripts.find(filePath);
+			if (script != scripts.end()) {
+				return script->second;
+			}
+
+			ScriptComponent component;
+			lua_State* L = lua.lua_state();
+			if (scriptCache.Load(L, filePath) != LUA_OK) {
+				LOG_ERROR("Error loading script %s: %s", filePath.c_str(), lua_tostring(L, -1));
+				lua_pop(L, 1);
+				scripts.emplace(filePath, component);
+				return component;
+			}
+
+			sol::protected_function chunk(L, -1);
+			lua_pop(L, 1);
+			sol::protected_function_result result = chunk();
+			if (!result.valid()) {
+				sol::error error = result;
+				LOG_ERROR("Error running script %s: %s", filePath.c_str(), error.what());
+			} else if (result.get_type() == sol::type::function) {
+				component.update = result.get<sol::protected_function>();
+			} else if (result.get_type() == sol::type::table && result.get<sol::table>()["update_all"].get_type() == sol::type::function) {
+				if (result.get<sol::table>()["parallel"].get_or(false) && workerPool.GetNumWorkers() > 0) {
+					component.parallelGroup = workerPool.AddGroup(filePath);
+				}
+				if (component.parallelGroup >= 0) {
+					scripts.emplace(filePath, component);
+					return component;
+				}
+
+				ScriptBatch batch;
+				batch.filePath = filePath;
+				batch.updateAll = result.get<sol::table>()["update_all"];
+				batches.push_back(batch);
+				batches.back().view = ComponentViews::CreateBatchView(lua.lua_state(), &batches.back().entities);
+				component.batch = static_cast<int>(batches.size()) - 1;
+			} else {
+				LOG_ERROR("Script %s must return its update function or a table with update_all", filePath.c_str());
+			}
+
+			scripts.emplace(filePath, component);
+			return component;
+		}
+
+		void Update(double deltaTime) {
+			PROFILE_SYSTEM("ScriptSystem");
+
+			const std::vector<ScriptMessage>& messages = workerPool.GetMessages();
+			if (!messages.empty()) {
+				sol::object handler = lua["on_message"];
+				if (handler.get_type() == sol::type::function) {
+					sol::protected_function onMessage = handler;
+					for (const auto& message: messages) {
+						sol::protected_function_result result = onMessage(message.topic, message.entityId, message.value);
+						if (!result.valid()) {
+							sol::error error = result;
+							LOG_ERROR("Script error in on_message: %s", error.what());
+							break;
+						}
+					}
+				}
+			}
+
+			for (auto& batch: batches) {
+				batch.entities.clear();
+			}
+			workerPool.ClearEntities();
+
+			for (const auto& entity: GetSystemEntities()) {
+				auto& script = entity.GetComponent<ScriptComponent>();
+				if (script.parallelGroup >= 0) {
+					workerPool.AddEntity(script.parallelGroup, entity);
+					continue;
+				}
+				if (script.batch >= 0) {
+					batches[script.batch].entities.push_back(entity);
+					continue;
+				}
+				if (!script.update.valid()) {
+					continue;
+				}
+				if (!script.self.valid()) {
+					script.self = sol::make_object(lua, entity);
+				}
+
+				if (scheduler) {
+					scheduler->SetCurrentOwner(entity.GetId());
+				}
+				sol::protected_function_result result = script.update(script.self, deltaTime);
+				if (scheduler) {
+					scheduler->SetCurrentOwner(-1);
+				}
+				if (!result.valid()) {
+					// Disabled rather than failing again every step
+					sol::error error = result;
+					LOG_ERROR("Script error on entity %d, script disabled: %s", entity.GetId(), error.what());
+					script.update = sol::lua_nil;
+				}
+			}
+
+			for (auto& batch: batches) {
+				if (batch.entities.empty() || !batch.updateAll.valid()) {
+					continue;
+				}
+
+				sol::protected_function_result result = batch.updateAll(batch.view, deltaTime);
+				if (!result.valid()) {
+					sol::error error = result;
+					LOG_ERROR("Script error in %s update_all, script disabled: %s", batch.filePath.c_str(), error.what());
+					batch.updateAll = sol::lua_nil;
+				}
+			}
+
+			// Waits for the workers, then applies their kills and gathers the messages for the next step
+			workerPool.Run(deltaTime);
+		}
+};
+
+#endif
@@ -1,22 +1,65 @@
 #include "Game.h"
 #include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
 #include "../ECS/ECS.h"
+#include "../ECS/Components/TransformComponent.h"
+#include "../ECS/Components/SpriteComponent.h"
+#include "../ECS/Components/AnimationComponent.h"
+#include "../ECS/Components/RigidBodyComponent.h"
+#include "../ECS/Components/ScriptComponent.h"
+#include "../ECS/Systems/MovementSystem.h"
+#include "../ECS/Systems/InterpolationSystem.h"
+#include "../ECS/Systems/CameraSystem.h"
+#include "../ECS/Systems/RenderSystem.h"
+#include "../ECS/Systems/AnimationSystem.h"
+#include "../ECS/Systems/ScriptSystem.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_render.h>
 #include <SDL2/SDL_image.h>
 #include <glm/glm.hpp>
+#include <cmath>
+#include <random>
+#include <string>
 
 
-Game::Game() {
+Game::Game(): framePacer(FPS), simulationClock(SIMULATION_TICKS_PER_SECOND, MAX_SIMULATION_STEPS_PER_FRAME),
+	lua(sol::default_at_panic, ScriptAllocator::Allocate, &scriptAllocator), scriptGarbageCollector(SCRIPT_GC_BUDGET_MICROS) {
 	isRunning = false;
+	renderMode = RENDER_WINDOW;
+	frameCount = 0;
+	traceFilePath = "trace.json";
+	exportTraceOnExit = false;
+	isStressTest = false;
+	scriptMemoryCapBytes = SCRIPT_MEMORY_CAP_MEGABYTES * 1024 * 1024;
+	scriptAllocator.SetCapBytes(scriptMemoryCapBytes);
+	scriptGcBudgetMicros = SCRIPT_GC_BUDGET_MICROS;
+	scriptCacheDirectory = SCRIPT_CACHE_DIRECTORY;
+	numScriptWorkers = 0;
+	isScriptLineProfile = false;
+	window = nullptr;
+	renderer = nullptr;
+	offscreenSurface = nullptr;
+	registry = new Registry();
+	assetStore = new AssetStore();
+	tilemap = nullptr;
 	Logger::Log("Game constructor called.");
 }
 
 Game::~Game() {
+	delete tilemap;
+	delete assetStore;
+	delete registry;
 	Logger::Log("Game destructor called.");
 }
 
-void Game::Initialize() {
+void Game::Initialize(RenderMode mode) {
+	renderMode = mode;
+
+	if (renderMode != RENDER_WINDOW) {
+		InitializeHeadless();
+		return;
+	}
+
 	if(SDL_Init(SDL_INIT_EVERYTHING) != 0) {
 		Logger::Err("Error initializing SDL");
 		return;
@@ -39,9 +82,13 @@ void Game::Initialize() {
 		return;
 	}
 
-	// Renderer params
-	renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED |
-	 SDL_RENDERER_PRESENTVSYNC);
+	// Renderer params. Vsync would cap an unlocked frame rate at the refresh rate, so it is only
+	// requested with a target set before this call
+	Uint32 rendererFlags = SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE;
+	if (!framePacer.IsUnlocked()) {
+		rendererFlags |= SDL_RENDERER_PRESENTVSYNC;
+	}
+	renderer = SDL_CreateRenderer(window, -1, rendererFlags);
 
 	if (!renderer){
 		Logger::Err("Error creating SDL renderer");
@@ -54,9 +101,39 @@ void Game::Initialize() {
 	isRunning = true;
 }
 
+void Game::InitializeHeadless() {
+	// Timer and events only: no display, no GPU and no video driver required
+	if (SDL_Init(SDL_INIT_TIMER | SDL_INIT_EVENTS) != 0) {
+		Logger::Err("Error initializing SDL");
+		return;
+	}
+	windowWidth = HEADLESS_WIDTH;
+	windowHeight = HEADLESS_HEIGHT;
+
+	if (renderMode == RENDER_OFFSCREEN) {
+		offscreenSurface = SDL_CreateRGBSurfaceWithFormat(0, windowWidth, windowHeight, 32, SDL_PIXELFORMAT_RGBA32);
+		if (!offscreenSurface) {
+			Logger::Err("Error creating offscreen surface");
+			return;
+		}
+
+		renderer = SDL_CreateSoftwareRenderer(offscreenSurface);
+		if (!renderer) {
+			Logger::Err("Error creating software renderer");
+			return;
+		}
+	}
+
+	Logger::Log(renderMode == RENDER_OFFSCREEN ? "Running headless with an offscreen renderer." : "Running headless.");
+	isRunning = true;
+}
+
 void Game::ProcessInput() {
+	PROFILE_SCOPE("Game::ProcessInput");
+
 	SDL_Event sdlEvent;
 	while (SDL_PollEvent(&sdlEvent)){
+		performanceOverlay.ProcessEvent(sdlEvent);
 		switch (sdlEvent.type) {
 		case SDL_QUIT:
 			isRunning = false;
@@ -65,6 +142,28 @@ void Game::ProcessInput() {
 			if (sdlEvent.key.keysym.sym == SDLK_ESCAPE) {
 				isRunning = false;
 			}
+			if (sdlEvent.key.keysym.sym == SDLK_F1) {
+				performanceOverlay.Toggle();
+			}
+			if (sdlEvent.key.keysym.sym == SDLK_F3) {
+				Profiler::ExportChromeTrace(traceFilePath, PROFILER_EXPORT_FRAMES);
+			}
+			break;
+		case SDL_RENDER_TARGETS_RESET:
+			// Target textures survive but lose what was drawn into them
+			if (tilemap) {
+				tilemap->Invalidate();
+			}
+			break;
+		case SDL_RENDER_DEVICE_RESET:
+			// Every texture of the old device is gone, so all of them are created again
+			if (tilemap) {
+				tilemap->ReleaseTextures();
+			}
+			assetStore->ClearAssets();
+			LoadTextures();
+			performanceOverlay.Destroy();
+			performanceOverlay.Initialize(renderer, windowWidth, windowHeight);
 			break;
 		}
 	}
@@ -72,52 +171,336 @@ void Game::ProcessInput() {
 
 
 
+void Game::LoadTextures() {
+	assetStore->AddTexture(renderer, "jungle-tileset", "./assets/tilemaps/jungle.png");
+	assetStore->AddTexture(renderer, "tank-image", "./assets/images/tank-panther-right.png");
+	assetStore->AddTexture(renderer, "truck-image", "./assets/images/truck-ford-right.png");
+	assetStore->AddTexture(renderer, "chopper-image", "./assets/images/chopper.png");
+	assetStore->AddTexture(renderer, "bullet-image", "./assets/images/bullet.png");
+}
+
 void Game::Setup(){
-	//TODO:
-	//Entity tank = registry.CreateEntity();
-	// tank.AddComponent<TransformComponent>();
-	// ...
+	registry->AddSystem<InterpolationSystem>();
+	registry->AddSystem<MovementSystem>();
+	registry->AddSystem<CameraSystem>(windowWidth, windowHeight);
+	registry->AddSystem<AnimationSystem>();
+	registry->AddSystem<RenderSystem>();
+
+	lua.open_libraries(sol::lib::base, sol::lib::math, sol::lib::string, sol::lib::table);
+	if (!scriptProfilePath.empty()) {
+		// Before any script runs, so coroutines inherit the hook
+		scriptProfiler.Attach(lua.lua_state(), SCRIPT_PROFILER_INSTRUCTIONS_PER_SAMPLE, isScriptLineProfile);
+	}
+	registry->AddSystem<ScriptSystem>(lua);
+	registry->GetSystem<ScriptSystem>().GetScriptCache().SetDirectory(scriptCacheDirectory);
+	registry->GetSystem<ScriptSystem>().GetWorkerPool().SetGcBudgetMicros(scriptGcBudgetMicros);
+	registry->GetSystem<ScriptSystem>().GetWorkerPool().Start(registry, numScriptWorkers, scriptMemoryCapBytes, scriptCacheDirectory);
+
+	// Everything that moves entities after they spawn reports them, so the camera re-indexes only those
+	std::vector<int>& movedEntityIds = registry->GetSystem<CameraSystem>().GetMovedEntityIds();
+	registry->GetSystem<MovementSystem>().SetMovedEntityIds(&movedEntityIds);
+	registry->GetSystem<ScriptSystem>().SetMovedEntityIds(&movedEntityIds);
+	scriptGarbageCollector.Attach(lua.lua_state());
+	scriptScheduler.Attach(lua.lua_state(), simulationClock.GetStepSeconds());
+	registry->GetSystem<ScriptSystem>().SetScheduler(&scriptScheduler);
+
+	// Textures need a renderer, pure headless runs simulate without them
+	if (renderer) {
+		LoadTextures();
+		performanceOverlay.Initialize(renderer, windowWidth, windowHeight);
+	}
+
+	tilemap = new Tilemap("jungle-tileset", 32, 2.0);
+	tilemap->LoadMap("./assets/tilemaps/jungle.map");
+	lua["world_width"] = tilemap->GetWidth();
+	lua["world_height"] = tilemap->GetHeight();
+	registry->GetSystem<ScriptSystem>().GetWorkerPool().SetGlobal("world_width", tilemap->GetWidth());
+	registry->GetSystem<ScriptSystem>().GetWorkerPool().SetGlobal("world_height", tilemap->GetHeight());
+
+	if (isStressTest) {
+		SpawnStressTest();
+	} else {
+		SpawnDemoScene();
+	}
+
+	const ScriptCacheStats& cacheStats = registry->GetSystem<ScriptSystem>().GetScriptCache().GetStats();
+	LOG_DEBUG("Scripts loaded, %llu from the cache and %llu compiled", cacheStats.hits, cacheStats.misses);
+}
+
+void Game::SpawnDemoScene() {
+	Entity tank = registry->CreateEntity();
+	tank.AddComponent<TransformComponent>(glm::vec2(100.0, 100.0), glm::vec2(1.0, 1.0), 0.0);
+	tank.AddComponent<RigidBodyComponent>(glm::vec2(40.0, 0.0));
+	tank.AddComponent<SpriteComponent>("tank-image", 32, 32);
+	tank.AddComponent<ScriptComponent>(registry->GetSystem<ScriptSystem>().LoadScript("./assets/scripts/patrol.lua"));
+
+	Entity truck = registry->CreateEntity();
+	truck.AddComponent<TransformComponent>(glm::vec2(300.0, 200.0), glm::vec2(1.0, 1.0), 0.0);
+	truck.AddComponent<RigidBodyComponent>(glm::vec2(0.0, 30.0));
+	truck.AddComponent<SpriteComponent>("truck-image", 32, 32);
+	truck.AddComponent<ScriptComponent>(registry->GetSystem<ScriptSystem>().LoadScript("./assets/scripts/stop_and_go.lua"));
+
+	Entity chopper = registry->CreateEntity();
+	chopper.AddComponent<TransformComponent>(glm::vec2(200.0, 300.0), glm::vec2(1.0, 1.0), 0.0);
+	chopper.AddComponent<SpriteComponent>("chopper-image", 32, 32);
+	chopper.AddComponent<AnimationComponent>(2, 10, true);
 }
 
 
 void Game::Update() {
 	// If too fast, stall until desired frame time
-	int timeToWait = MILLISECONDS_PER_FRAME - (SDL_GetTicks()- msPreviousFrame); 
-	if (timeToWait > 0 && timeToWait <= MILLISECONDS_PER_FRAME){
-		SDL_Delay(timeToWait);
+	double frameSeconds = framePacer.WaitForNextFrame();
+
+	// Benchmarks simulate the same time every frame no matter how long the frame took
+	if (isStressTest) {
+		frameSeconds = simulationClock.GetStepSeconds();
+	}
+
+	PROFILE_SCOPE("Game::Update");
+
+	// Run the simulation as many fixed steps as the elapsed time covers
+	const int steps = simulationClock.Advance(frameSeconds);
+	const double deltaTime = simulationClock.GetStepSeconds();
+	for (int step = 0; step < steps; step++) {
+		// Add/remove entities that are waiting to be created/destroyed
+		registry->Update();
+
+		registry->GetSystem<InterpolationSystem>().Update();
+		registry->GetSystem<ScriptSystem>().Update(deltaTime);
+		scriptScheduler.Tick();
+		registry->GetSystem<MovementSystem>().Update(deltaTime);
+
+		simulationClock.Step();
 	}
-	
-	// The difference in ticks since the last frame, converted into seconds
-	double deltaTime = (SDL_GetTicks() - msPreviousFrame) / 1000.0;
 
-	msPreviousFrame = SDL_GetTicks();
+	// Collect what intersects the view before anything per-entity runs
+	auto& cameraSystem = registry->GetSystem<CameraSystem>();
+	cameraSystem.ClampToBounds(tilemap->GetWidth(), tilemap->GetHeight());
+	cameraSystem.Update();
 
-	// TODO:
-	// MovementSystem.Update();
-	//...
+	registry->GetSystem<AnimationSystem>().Update(cameraSystem.GetVisibleEntities());
 
 }
 
 void Game::Render() {
+	if (!renderer) {
+		return;
+	}
+
+	PROFILE_SCOPE("Game::Render");
+
 	SDL_SetRenderDrawColor(renderer, 21, 21, 21, 255);
 	SDL_RenderClear(renderer);
 
-	// TODO: Render game objects
-	
+	auto& cameraSystem = registry->GetSystem<CameraSystem>();
+	tilemap->Render(renderer, assetStore, cameraSystem.GetView());
+
+	registry->GetSystem<RenderSystem>().Update(renderer, assetStore, cameraSystem.GetView(), cameraSystem.GetVisibleEntities(), simulationClock.GetAlpha());
+
+	performanceOverlay.Render(*registry);
+
 	SDL_RenderPresent(renderer);
 }
 
-void Game::Run() {
+void Game::Run(unsigned long long maxFrames) {
+	Profiler::SetThreadName("Main");
 	Setup();
+
+	if (isStressTest) {
+		if (maxFrames == 0) {
+			maxFrames = STRESS_TEST_DEFAULT_FRAMES;
+		}
+		frameBenchmark.Reserve(maxFrames);
+	}
+
 	while(isRunning) {
+		Profiler::BeginFrame();
+
+		// BeginFrame just published frame frameCount - 1
+		if (isStressTest && frameCount > stressTest.warmupFrames) {
+			frameBenchmark.RecordFrame();
+		}
+
 		ProcessInput();
 		Update();
 		Render();
+
+		// Idle slice after the frame is presented, before the pacer waits for the next one
+		scriptGarbageCollector.Step();
+		registry->GetSystem<ScriptSystem>().GetWorkerPool().StepGarbageCollectors();
+		scriptProfiler.PublishFrame();
+
+		frameCount++;
+		if (maxFrames != 0 && frameCount >= maxFrames) {
+			isRunning = false;
+		}
+	}
+
+	if (isStressTest) {
+		// Closes the last frame so it is measured too
+		Profiler::BeginFrame();
+		if (frameCount > stressTest.warmupFrames) {
+			frameBenchmark.RecordFrame();
+		}
+		WriteStressTestReport();
 	}
 }
 
 void Game::Destroy() {
-	SDL_DestroyRenderer(renderer);
-	SDL_DestroyWindow(window);
+	if (exportTraceOnExit) {
+		Profiler::ExportChromeTrace(traceFilePath);
+	}
+	if (scriptProfiler.IsAttached()) {
+		scriptProfiler.WriteFoldedStacks(scriptProfilePath);
+		scriptProfiler.WriteLineTimes(scriptProfilePath + ".lines");
+		scriptProfiler.Detach();
+	}
+
+	performanceOverlay.Destroy();
+	assetStore->ClearAssets();
+	delete tilemap;
+	tilemap = nullptr;
+	if (renderer) {
+		SDL_DestroyRenderer(renderer);
+		renderer = nullptr;
+	}
+	if (offscreenSurface) {
+		SDL_FreeSurface(offscreenSurface);
+		offscreenSurface = nullptr;
+	}
+	if (window) {
+		SDL_DestroyWindow(window);
+		window = nullptr;
+	}
 	SDL_Quit();
-}
\ No newline at end of file
+}
+
+void Game::SetTickRate(double ticksPerSecond) {
+	simulationClock.SetTickRate(ticksPerSecond);
+}
+
+void Game::SetTargetFps(double targetFps) {
+	framePacer.SetTargetFps(targetFps);
+}
+
+void Game::SetTraceFile(const std::string& filePath) {
+	traceFilePath = filePath;
+	exportTraceOnExit = true;
+}
+
+void Game::SetScriptGcBudget(int budgetMicros) {
+	scriptGcBudgetMicros = budgetMicros;
+	scriptGarbageCollector.SetBudgetMicros(budgetMicros);
+	if (registry->HasSystem<ScriptSystem>()) {
+		registry->GetSystem<ScriptSystem>().GetWorkerPool().SetGcBudgetMicros(budgetMicros);
+	}
+}
+
+void Game::SetScriptMemoryCap(size_t megabytes) {
+	scriptMemoryCapBytes = megabytes * 1024 * 1024;
+	scriptAllocator.SetCapBytes(scriptMemoryCapBytes);
+}
+
+void Game::SetScriptCacheDirectory(const std::string& directory) {
+	scriptCacheDirectory = directory;
+}
+
+void Game::SetScriptProfile(const std::string& filePath, bool isLineMode) {
+	scriptProfilePath = filePath;
+	isScriptLineProfile = isLineMode;
+}
+
+void Game::SetScriptWorkers(int numWorkers) {
+	numScriptWorkers = numWorkers;
+}
+
+void Game::SetStressTest(const StressTestConfig& config) {
+	stressTest = config;
+	isStressTest = true;
+
+	// As fast as the frames go, the pacer would only add idle time to the measurements
+	framePacer.SetTargetFps(0.0);
+}
+
+void Game::SpawnStressTest() {
+	std::mt19937 random(stressTest.seed);
+	std::uniform_real_distribution<float> randomX(0.0f, static_cast<float>(tilemap->GetWidth() - 32));
+	std::uniform_real_distribution<float> randomY(0.0f, static_cast<float>(tilemap->GetHeight() - 32));
+	std::uniform_real_distribution<float> randomAngle(0.0f, 6.2831853f);
+	std::uniform_real_distribution<float> randomUnit(0.0f, 1.0f);
+
+	const ScriptComponent patrol = registry->GetSystem<ScriptSystem>().LoadScript("./assets/scripts/patrol.lua");
+	int numScripted = 0;
+
+	// Ground vehicles drive along one axis, like their sprites face
+	auto spawnVehicle = [&](const char* assetId, float minSpeed, float maxSpeed) {
+		const float speed = minSpeed + (maxSpeed - minSpeed) * randomUnit(random);
+		const bool isHorizontal = randomUnit(random) < 0.5f;
+		const float direction = randomUnit(random) < 0.5f ? -1.0f : 1.0f;
+
+		Entity vehicle = registry->CreateEntity();
+		vehicle.AddComponent<TransformComponent>(glm::vec2(randomX(random), randomY(random)), glm::vec2(1.0, 1.0), 0.0);
+		vehicle.AddComponent<RigidBodyComponent>(isHorizontal ? glm::vec2(speed * direction, 0.0) : glm::vec2(0.0, speed * direction));
+		vehicle.AddComponent<SpriteComponent>(assetId, 32, 32);
+		if (numScripted < stressTest.numScripted) {
+			vehicle.AddComponent<ScriptComponent>(patrol);
+			numScripted++;
+		}
+	};
+
+	for (int i = 0; i < stressTest.numTanks; i++) {
+		spawnVehicle("tank-image", 20.0f, 50.0f);
+	}
+	for (int i = 0; i < stressTest.numTrucks; i++) {
+		spawnVehicle("truck-image", 30.0f, 70.0f);
+	}
+
+	for (int i = 0; i < stressTest.numChoppers; i++) {
+		const float angle = randomAngle(random);
+		const float speed = 60.0f + 60.0f * randomUnit(random);
+
+		Entity chopper = registry->CreateEntity();
+		chopper.AddComponent<TransformComponent>(glm::vec2(randomX(random), randomY(random)), glm::vec2(1.0, 1.0), 0.0);
+		chopper.AddComponent<RigidBodyComponent>(glm::vec2(std::cos(angle) * speed, std::sin(angle) * speed));
+		chopper.AddComponent<SpriteComponent>("chopper-image", 32, 32);
+		chopper.AddComponent<AnimationComponent>(2, 10, true);
+	}
+
+	for (int i = 0; i < stressTest.numBullets; i++) {
+		const float angle = randomAngle(random);
+		const float speed = 150.0f + 150.0f * randomUnit(random);
+
+		Entity bullet = registry->CreateEntity();
+		bullet.AddComponent<TransformComponent>(glm::vec2(randomX(random), randomY(random)), glm::vec2(1.0, 1.0), 0.0);
+		bullet.AddComponent<RigidBodyComponent>(glm::vec2(std::cos(angle) * speed, std::sin(angle) * speed));
+		bullet.AddComponent<SpriteComponent>("bullet-image", 4, 4);
+	}
+
+	LOG_INFO("Stress test: %d tanks, %d trucks, %d choppers, %d bullets, %d scripted, seed %u",
+		stressTest.numTanks, stressTest.numTrucks, stressTest.numChoppers, stressTest.numBullets, numScripted, stressTest.seed);
+}
+
+void Game::WriteStressTestReport() {
+	const long long numEntities = registry->GetNumEntities();
+
+	BenchmarkReport report("scene");
+	report.SetMetadata("seed", std::to_string(stressTest.seed));
+	report.SetMetadata("tanks", std::to_string(stressTest.numTanks));
+	report.SetMetadata("trucks", std::to_string(stressTest.numTrucks));
+	report.SetMetadata("choppers", std::to_string(stressTest.numChoppers));
+	report.SetMetadata("bullets", std::to_string(stressTest.numBullets));
+	report.SetMetadata("scripted", std::to_string(stressTest.numScripted));
+	report.SetMetadata("script_workers", std::to_string(numScriptWorkers));
+	report.SetMetadata("lua_gc_cycles", std::to_string(scriptGarbageCollector.GetStats().cycles));
+	report.SetMetadata("lua_kilobytes", std::to_string(scriptGarbageCollector.GetStats().kilobytesInUse));
+	report.SetMetadata("lua_peak_kilobytes", std::to_string(scriptAllocator.GetStats().peakBytesInUse / 1024));
+	report.SetMetadata("warmup_frames", std::to_string(stressTest.warmupFrames));
+	report.SetMetadata("measured_frames", std::to_string(frameBenchmark.GetFrameCount()));
+	report.SetMetadata("render_mode", renderMode == RENDER_WINDOW ? "window" : renderMode == RENDER_OFFSCREEN ? "offscreen" : "headless");
+	frameBenchmark.AddToReport(report, numEntities);
+
+	frameBenchmark.LogSummary();
+	if (report.WriteJson(stressTest.reportPath)) {
+		LOG_INFO("Benchmark report written to %s", stressTest.reportPath.c_str());
+	}
+}
@@ -2,31 +2,129 @@
 #define GAME_H
 
 #include "../ECS/ECS.h"
+#include "../AssetStore/AssetStore.h"
+#include "../Tilemap/Tilemap.h"
+#include "../Timing/FixedTimestep.h"
+#include "../Timing/FramePacer.h"
+#include "../Debug/PerformanceOverlay.h"
+#include "../Benchmark/FrameBenchmark.h"
+#include "../Scripting/ScriptAllocator.h"
+#include "../Scripting/ScriptGarbageCollector.h"
+#include "../Scripting/ScriptProfiler.h"
+#include "../Scripting/ScriptScheduler.h"
 #include <SDL2/SDL.h>
+#include <sol/sol.hpp>
+#include <string>
 
-// Optional fps cap
-const int FPS = 60;
-const int MILLISECONDS_PER_FRAME = 1000 / FPS;
+// Optional fps cap, fractional rates are fine and zero runs unlocked
+const double FPS = 60.0;
+
+// Simulation runs in fixed steps independent of the frame rate
+const double SIMULATION_TICKS_PER_SECOND = 60.0;
+
+// Upper bound on catch-up steps after a slow frame, the rest of the backlog is dropped
+const int MAX_SIMULATION_STEPS_PER_FRAME = 5;
+
+// Output size when there is no display to size the window from
+const int HEADLESS_WIDTH = 1280;
+const int HEADLESS_HEIGHT = 720;
+
+// Frames written when a trace is exported from the keyboard (F3)
+const size_t PROFILER_EXPORT_FRAMES = 300;
+
+// Lua garbage collection time per frame, spent after rendering
+const int SCRIPT_GC_BUDGET_MICROS = 1000;
+
+// Scripts beyond this much Lua memory fail with "not enough memory", zero for no cap
+const size_t SCRIPT_MEMORY_CAP_MEGABYTES = 256;
+
+// Frames run by a stress test when no frame count is given
+const unsigned long long STRESS_TEST_DEFAULT_FRAMES = 1000;
+
+// Procedurally spawned scene for end-to-end benchmarks, see Game::SetStressTest
+struct StressTestConfig {
+	int numTanks = 500;
+	int numTrucks = 500;
+	int numChoppers = 250;
+	int numBullets = 2000;
+	int numScripted = 1000;  // Tanks and trucks that also run assets/scripts/patrol.lua
+	unsigned int seed = 1;
+	unsigned long long warmupFrames = 60;  // Run but left out of the report
+	std::string reportPath = "benchmark.json";
+};
+
+enum RenderMode {
+	RENDER_WINDOW,    // Borderless full screen window with an accelerated vsync renderer
+	RENDER_HEADLESS,  // No video subsystem and no renderer, simulation only
+	RENDER_OFFSCREEN  // No window, software renderer drawing into a memory surface
+};
 
 class Game {
 private:
 	bool isRunning;
-	int msPreviousFrame;
+	RenderMode renderMode;
+	unsigned long long frameCount;
+	std::string traceFilePath;
+	bool exportTraceOnExit;
+	FramePacer framePacer;
+	FixedTimestep simulationClock;
+	PerformanceOverlay performanceOverlay;
+	bool isStressTest;
+	StressTestConfig stressTest;
+	FrameBenchmark frameBenchmark;
 	SDL_Window* window;
 	SDL_Renderer* renderer;
+	SDL_Surface* offscreenSurface;
+	ScriptAllocator scriptAllocator;  // Declared before lua, which allocates through it until destroyed
+	sol::state lua;
+	ScriptGarbageCollector scriptGarbageCollector;
+	ScriptScheduler scriptScheduler;
+	ScriptProfiler scriptProfiler;  // Declared after lua, unhooks it before it closes
+	std::string scriptProfilePath;
+	bool isScriptLineProfile;
+	std::string scriptCacheDirectory;
+	size_t scriptMemoryCapBytes;
+	int scriptGcBudgetMicros;
+	int numScriptWorkers;
 
 	Registry* registry;
+	AssetStore* assetStore;
+	Tilemap* tilemap;
+
+	void LoadTextures();
 
 public:
 	Game();
 	~Game();
-	void Initialize();
-	void Run();
+	void Initialize(RenderMode mode = RENDER_WINDOW);
+	void InitializeHeadless();
+	// Runs until quit, or for maxFrames frames when it is not zero
+	void Run(unsigned long long maxFrames = 0);
 	void Setup();
+	void SpawnDemoScene();
 	void ProcessInput();
 	void Update();
 	void Render();
 	void Destroy();
+	void SetTickRate(double ticksPerSecond);
+	// Zero runs unlocked. Call before Initialize, which leaves vsync off for unlocked window renderers
+	void SetTargetFps(double targetFps);
+	// Exports the profiler trace here on Destroy, and on F3 while running
+	void SetTraceFile(const std::string& filePath);
+	void SetScriptGcBudget(int budgetMicros);
+	void SetScriptMemoryCap(size_t megabytes);
+	// Compiled scripts are kept here between runs, empty compiles every script on every start
+	void SetScriptCacheDirectory(const std::string& directory);
+	// Samples the main Lua state and writes folded stacks here on Destroy, and per-line times next to them
+	// in <path>.lines. Line mode times every executed line instead of sampling them
+	void SetScriptProfile(const std::string& filePath, bool isLineMode);
+	// Threads for scripts that set parallel = true, each with its own Lua state, zero runs them on the main state
+	void SetScriptWorkers(int numWorkers);
+	// Replaces the demo scene with a seeded one and benchmarks it, the simulation then advances exactly
+	// one fixed step per frame so every run does the same work
+	void SetStressTest(const StressTestConfig& config);
+	void SpawnStressTest();
+	void WriteStressTestReport();
 	int windowWidth;
 	int windowHeight;
 };
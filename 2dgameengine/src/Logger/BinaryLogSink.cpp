@@ -0,0 +1,155 @@
+#include "BinaryLogSink.h"
+#include "LogFormat.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+BinaryLogSink::~BinaryLogSink() {
+	Close();
+}
+
+bool BinaryLogSink::Open(const std::string& filePath, size_t ringSizeBytes) {
+	Close();
+
+	// Whole blocks only, and at least two so the reader always has one intact block behind the writer
+	size_t blocks = (ringSizeBytes + BINARY_LOG_BLOCK_SIZE - 1) / BINARY_LOG_BLOCK_SIZE;
+	if (blocks < 2) {
+		blocks = 2;
+	}
+	const size_t ringSize = blocks * BINARY_LOG_BLOCK_SIZE;
+
+	rename(filePath.c_str(), (filePath + ".1").c_str());
+
+	fileDescriptor = open(filePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fileDescriptor < 0) {
+		return false;
+	}
+
+	mappingSize = BINARY_LOG_HEADER_SIZE + BINARY_LOG_FORMAT_TABLE_SIZE + ringSize;
+	if (ftruncate(fileDescriptor, static_cast<off_t>(mappingSize)) != 0) {
+		Close();
+		return false;
+	}
+
+	void* address = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+	if (address == MAP_FAILED) {
+		Close();
+		return false;
+	}
+	mapping = static_cast<uint8_t*>(address);
+
+	header = reinterpret_cast<BinaryLogHeader*>(mapping);
+	memcpy(header->magic, BINARY_LOG_MAGIC, sizeof(header->magic));
+	header->version = BINARY_LOG_VERSION;
+	header->blockSize = BINARY_LOG_BLOCK_SIZE;
+	header->formatTableOffset = BINARY_LOG_HEADER_SIZE;
+	header->formatTableCapacity = BINARY_LOG_FORMAT_TABLE_SIZE;
+	header->formatTableUsed = 0;
+	header->ringOffset = BINARY_LOG_HEADER_SIZE + BINARY_LOG_FORMAT_TABLE_SIZE;
+	header->ringSize = ringSize;
+	header->writePosition = 0;
+	header->recordCount = 0;
+	header->openedAt = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+
+	formatIds.clear();
+	nextFormatId = 0;
+	uint32_t textFormatId;
+	RegisterFormat("%s", textFormatId);
+	return true;
+}
+
+void BinaryLogSink::Close() {
+	if (mapping) {
+		msync(mapping, mappingSize, MS_ASYNC);
+		munmap(mapping, mappingSize);
+		mapping = nullptr;
+		header = nullptr;
+	}
+	if (fileDescriptor >= 0) {
+		close(fileDescriptor);
+		fileDescriptor = -1;
+	}
+}
+
+bool BinaryLogSink::RegisterFormat(const char* format, uint32_t& formatId) {
+	auto found = formatIds.find(format);
+	if (found != formatIds.end()) {
+		formatId = found->second;
+		return true;
+	}
+
+	const uint32_t length = static_cast<uint32_t>(strlen(format));
+	const uint64_t entrySize = sizeof(BinaryLogFormatEntry) + length;
+	if (header->formatTableUsed + entrySize > header->formatTableCapacity) {
+		return false;
+	}
+
+	uint8_t* entry = mapping + header->formatTableOffset + header->formatTableUsed;
+	BinaryLogFormatEntry entryHeader = {nextFormatId, length};
+	memcpy(entry, &entryHeader, sizeof(entryHeader));
+	memcpy(entry + sizeof(entryHeader), format, length);
+
+	// Publish the entry only once its bytes are in place
+	__atomic_store_n(&header->formatTableUsed, header->formatTableUsed + entrySize, __ATOMIC_RELEASE);
+
+	formatId = nextFormatId++;
+	formatIds[format] = formatId;
+	return true;
+}
+
+void BinaryLogSink::Append(uint8_t level, uint32_t formatId, int64_t timestamp, const uint8_t* payload, size_t payloadSize) {
+	const size_t recordSize = (sizeof(BinaryLogRecordHeader) + payloadSize + 7) & ~static_cast<size_t>(7);
+	if (recordSize > BINARY_LOG_BLOCK_SIZE || recordSize > UINT16_MAX) {
+		return;
+	}
+
+	uint64_t position = header->writePosition;
+	const uint64_t blockRemaining = BINARY_LOG_BLOCK_SIZE - position % BINARY_LOG_BLOCK_SIZE;
+
+	// Close the block with a zero word and start the record at the next one
+	if (recordSize > blockRemaining) {
+		uint32_t endOfBlock = 0;
+		memcpy(mapping + header->ringOffset + position % header->ringSize, &endOfBlock, sizeof(endOfBlock));
+		position += blockRemaining;
+	}
+
+	uint8_t* destination = mapping + header->ringOffset + position % header->ringSize;
+
+	BinaryLogRecordHeader recordHeader;
+	recordHeader.marker = BINARY_LOG_RECORD_MARKER;
+	recordHeader.size = static_cast<uint16_t>(recordSize);
+	recordHeader.level = level;
+	recordHeader.reserved = 0;
+	recordHeader.formatId = formatId;
+	recordHeader.payloadSize = static_cast<uint32_t>(payloadSize);
+	recordHeader.timestamp = timestamp;
+	memcpy(destination, &recordHeader, sizeof(recordHeader));
+	memcpy(destination + sizeof(recordHeader), payload, payloadSize);
+
+	header->recordCount++;
+	__atomic_store_n(&header->writePosition, position + recordSize, __ATOMIC_RELEASE);
+}
+
+void BinaryLogSink::Write(uint8_t level, const char* format, int64_t timestamp, const uint8_t* payload, size_t payloadSize) {
+	if (!mapping) {
+		return;
+	}
+
+	uint32_t formatId;
+	if (RegisterFormat(format, formatId)) {
+		Append(level, formatId, timestamp, payload, payloadSize);
+		return;
+	}
+
+	// Format table full: store the expanded text instead
+	char text[LOG_PAYLOAD_SIZE];
+	FormatLogMessage(format, payload, payloadSize, text, sizeof(text));
+	uint8_t textPayload[LOG_PAYLOAD_SIZE];
+	LogArgEncoder encoder(textPayload, sizeof(textPayload));
+	encoder.Add(static_cast<const char*>(text));
+	Append(level, BINARY_LOG_TEXT_FORMAT_ID, timestamp, textPayload, encoder.GetSize());
+}
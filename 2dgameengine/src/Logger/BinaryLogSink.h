@@ -0,0 +1,95 @@
+#ifndef BINARYLOGSINK_H
+#define BINARYLOGSINK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Binary log file layout, shared with tools/LogDecoder.
+//
+//   [BinaryLogHeader, padded to BINARY_LOG_HEADER_SIZE]
+//   [format table: BinaryLogFormatEntry + format string bytes, appended as new formats show up]
+//   [ring: blocks of BINARY_LOG_BLOCK_SIZE bytes holding BinaryLogRecordHeader + raw argument payload]
+//
+// Records never straddle blocks, so a reader can always start cleanly at the oldest intact block.
+// The header's writePosition is published after each record, whatever lies past it is ignored.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char BINARY_LOG_MAGIC[8] = {'E', 'N', 'G', 'L', 'O', 'G', '0', '1'};
+const uint32_t BINARY_LOG_VERSION = 1;
+const uint32_t BINARY_LOG_HEADER_SIZE = 4096;
+const uint32_t BINARY_LOG_BLOCK_SIZE = 64 * 1024;
+const uint64_t BINARY_LOG_FORMAT_TABLE_SIZE = 1024 * 1024;
+
+// First word of every record, a zero word instead ends the block
+const uint32_t BINARY_LOG_RECORD_MARKER = 0x474F4C52;
+
+// Format id of "%s", used for records whose format did not fit in the table
+const uint32_t BINARY_LOG_TEXT_FORMAT_ID = 0;
+
+struct BinaryLogHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t blockSize;
+	uint64_t formatTableOffset;
+	uint64_t formatTableCapacity;
+	uint64_t formatTableUsed;
+	uint64_t ringOffset;
+	uint64_t ringSize;
+	uint64_t writePosition;  // Bytes written into the ring since the file was opened
+	uint64_t recordCount;
+	int64_t openedAt;        // Wall clock, nanoseconds since the epoch
+};
+
+struct BinaryLogFormatEntry {
+	uint32_t id;
+	uint32_t length;
+};
+
+struct BinaryLogRecordHeader {
+	uint32_t marker;
+	uint16_t size;  // Whole record including this header, a multiple of 8
+	uint8_t level;
+	uint8_t reserved;
+	uint32_t formatId;
+	uint32_t payloadSize;
+	int64_t timestamp;  // Wall clock, nanoseconds since the epoch
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// BinaryLogSink: Appends log records to a memory-mapped ring file. Since the mapping is shared with
+// the page cache, everything published survives the process crashing.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class BinaryLogSink {
+	private:
+		int fileDescriptor = -1;
+		uint8_t* mapping = nullptr;
+		size_t mappingSize = 0;
+		BinaryLogHeader* header = nullptr;
+
+		std::unordered_map<const char*, uint32_t> formatIds;
+		uint32_t nextFormatId = 0;
+
+		bool RegisterFormat(const char* format, uint32_t& formatId);
+		void Append(uint8_t level, uint32_t formatId, int64_t timestamp, const uint8_t* payload, size_t payloadSize);
+
+	public:
+		BinaryLogSink() = default;
+		~BinaryLogSink();
+
+		BinaryLogSink(const BinaryLogSink&) = delete;
+		BinaryLogSink& operator = (const BinaryLogSink&) = delete;
+
+		// Creates the file, an existing one is kept next to it with a ".1" suffix
+		bool Open(const std::string& filePath, size_t ringSizeBytes);
+		void Close();
+		bool IsOpen() const { return mapping != nullptr; }
+
+		// Format strings are identified by address, they must be literals as with the LOG_* macros
+		void Write(uint8_t level, const char* format, int64_t timestamp, const uint8_t* payload, size_t payloadSize);
+};
+
+#endif
@@ -0,0 +1,228 @@
+#include "LogFormat.h"
+#include <cstdarg>
+#include <cstdio>
+
+namespace {
+	struct LogArg {
+		LogArgType type;
+		int64_t integer;
+		uint64_t unsignedInteger;
+		double number;
+		const char* text;
+		uint16_t textLength;
+	};
+
+	class LogArgReader {
+		private:
+			const uint8_t* payload;
+			size_t size;
+			size_t offset = 0;
+			bool isValid = true;
+
+			// Payloads may come from a file, never read past the end of one
+			template <typename T>
+			T ReadValue() {
+				T value = T();
+				if (offset + sizeof(T) > size) {
+					isValid = false;
+					return value;
+				}
+				memcpy(&value, payload + offset, sizeof(T));
+				offset += sizeof(T);
+				return value;
+			}
+
+		public:
+			LogArgReader(const uint8_t* payload, size_t size): payload(payload), size(size) {}
+
+			bool Next(LogArg& arg) {
+				if (!isValid || offset >= size) {
+					return false;
+				}
+				arg = LogArg();
+				arg.type = static_cast<LogArgType>(payload[offset++]);
+				switch (arg.type) {
+					case LOG_ARG_INT32: arg.integer = ReadValue<int32_t>(); break;
+					case LOG_ARG_UINT32: arg.unsignedInteger = ReadValue<uint32_t>(); break;
+					case LOG_ARG_INT64: arg.integer = ReadValue<int64_t>(); break;
+					case LOG_ARG_UINT64:
+					case LOG_ARG_POINTER: arg.unsignedInteger = ReadValue<uint64_t>(); break;
+					case LOG_ARG_DOUBLE: arg.number = ReadValue<double>(); break;
+					case LOG_ARG_STRING:
+						arg.textLength = ReadValue<uint16_t>();
+						if (offset + arg.textLength > size || arg.textLength > LOG_PAYLOAD_SIZE) {
+							isValid = false;
+							break;
+						}
+						arg.text = reinterpret_cast<const char*>(payload + offset);
+						offset += arg.textLength;
+						break;
+					default:
+						isValid = false;
+						break;
+				}
+				return isValid;
+			}
+	};
+
+	bool IsSigned(LogArgType type) {
+		return type == LOG_ARG_INT32 || type == LOG_ARG_INT64;
+	}
+
+	int64_t AsInteger(const LogArg& arg) {
+		if (arg.type == LOG_ARG_DOUBLE) {
+			return static_cast<int64_t>(arg.number);
+		}
+		return IsSigned(arg.type) ? arg.integer : static_cast<int64_t>(arg.unsignedInteger);
+	}
+
+	double AsDouble(const LogArg& arg) {
+		if (arg.type == LOG_ARG_DOUBLE) {
+			return arg.number;
+		}
+		return IsSigned(arg.type) ? static_cast<double>(arg.integer) : static_cast<double>(arg.unsignedInteger);
+	}
+
+	// Appends with snprintf semantics but never past the end of the buffer
+	void Append(char* out, size_t outSize, size_t& length, const char* spec, ...) __attribute__((format(printf, 4, 5)));
+	void Append(char* out, size_t outSize, size_t& length, const char* spec, ...) {
+		if (length + 1 >= outSize) {
+			return;
+		}
+		va_list args;
+		va_start(args, spec);
+		int written = vsnprintf(out + length, outSize - length, spec, args);
+		va_end(args);
+		if (written > 0) {
+			length += static_cast<size_t>(written) < outSize - length ? written : outSize - length - 1;
+		}
+	}
+}
+
+size_t FormatLogMessage(const char* format, const uint8_t* payload, size_t payloadSize, char* out, size_t outSize) {
+	if (outSize == 0) {
+		return 0;
+	}
+
+	LogArgReader reader(payload, payloadSize);
+	size_t length = 0;
+	out[0] = '\0';
+
+	const char* cursor = format;
+	while (*cursor && length + 1 < outSize) {
+		if (*cursor != '%') {
+			out[length++] = *cursor++;
+			continue;
+		}
+		if (cursor[1] == '%') {
+			out[length++] = '%';
+			cursor += 2;
+			continue;
+		}
+
+		// Copy flags, width and precision; drop length modifiers, the stored type decides those
+		char spec[32];
+		size_t specLength = 0;
+		spec[specLength++] = *cursor++;
+		int starArgs[2];
+		int starCount = 0;
+		while (*cursor && strchr("-+ #0123456789.*hlLqjzt", *cursor)) {
+			if (*cursor == '*') {
+				LogArg starArg;
+				if (starCount < 2 && reader.Next(starArg)) {
+					starArgs[starCount++] = static_cast<int>(AsInteger(starArg));
+				}
+			}
+			if (!strchr("hlLqjzt", *cursor) && specLength < sizeof(spec) - 4) {
+				spec[specLength++] = *cursor;
+			}
+			cursor++;
+		}
+		if (!*cursor) {
+			break;
+		}
+		const char conversion = *cursor++;
+
+		LogArg arg;
+		if (!reader.Next(arg)) {
+			Append(out, outSize, length, "%s", "<missing>");
+			continue;
+		}
+
+		if (strchr("diouxX", conversion)) {
+			spec[specLength++] = 'l';
+			spec[specLength++] = 'l';
+		}
+		spec[specLength++] = conversion;
+		spec[specLength] = '\0';
+
+		// The spec is rebuilt at runtime, the call site was already checked against the format attribute
+		#pragma GCC diagnostic push
+		#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+		#pragma GCC diagnostic ignored "-Wformat-security"
+		switch (conversion) {
+			case 'd':
+			case 'i': {
+				long long value = AsInteger(arg);
+				if (starCount == 2) Append(out, outSize, length, spec, starArgs[0], starArgs[1], value);
+				else if (starCount == 1) Append(out, outSize, length, spec, starArgs[0], value);
+				else Append(out, outSize, length, spec, value);
+				break;
+			}
+			case 'c': {
+				int value = static_cast<int>(AsInteger(arg));
+				if (starCount >= 1) Append(out, outSize, length, spec, starArgs[0], value);
+				else Append(out, outSize, length, spec, value);
+				break;
+			}
+			case 'o':
+			case 'u':
+			case 'x':
+			case 'X': {
+				unsigned long long value = static_cast<unsigned long long>(AsInteger(arg));
+				if (starCount == 2) Append(out, outSize, length, spec, starArgs[0], starArgs[1], value);
+				else if (starCount == 1) Append(out, outSize, length, spec, starArgs[0], value);
+				else Append(out, outSize, length, spec, value);
+				break;
+			}
+			case 'f':
+			case 'F':
+			case 'e':
+			case 'E':
+			case 'g':
+			case 'G':
+			case 'a':
+			case 'A': {
+				double value = AsDouble(arg);
+				if (starCount == 2) Append(out, outSize, length, spec, starArgs[0], starArgs[1], value);
+				else if (starCount == 1) Append(out, outSize, length, spec, starArgs[0], value);
+				else Append(out, outSize, length, spec, value);
+				break;
+			}
+			case 's': {
+				if (arg.type != LOG_ARG_STRING) {
+					Append(out, outSize, length, "%s", "<not a string>");
+					break;
+				}
+				// Stored strings are not terminated
+				char text[LOG_PAYLOAD_SIZE + 1];
+				memcpy(text, arg.text, arg.textLength);
+				text[arg.textLength] = '\0';
+				if (starCount == 2) Append(out, outSize, length, spec, starArgs[0], starArgs[1], text);
+				else if (starCount == 1) Append(out, outSize, length, spec, starArgs[0], text);
+				else Append(out, outSize, length, spec, text);
+				break;
+			}
+			case 'p':
+				Append(out, outSize, length, "0x%llx", static_cast<unsigned long long>(arg.unsignedInteger));
+				break;
+			default:
+				Append(out, outSize, length, "%%%c", conversion);
+				break;
+		}
+		#pragma GCC diagnostic pop
+	}
+
+	out[length] = '\0';
+	return length;
+}
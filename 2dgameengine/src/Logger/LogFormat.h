@@ -0,0 +1,111 @@
+#ifndef LOGFORMAT_H
+#define LOGFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Deferred printf-style formatting: arguments are captured as tagged raw values at the call site and
+// only turned into text later, by whoever reads the record.
+//
+// Payload layout, one entry per argument: [LogArgType: 1 byte][value]
+//   integers and pointers: 4 or 8 bytes, doubles: 8 bytes, strings: [length: 2 bytes][bytes]
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum LogArgType : uint8_t {
+	LOG_ARG_INT32,
+	LOG_ARG_UINT32,
+	LOG_ARG_INT64,
+	LOG_ARG_UINT64,
+	LOG_ARG_DOUBLE,
+	LOG_ARG_STRING,
+	LOG_ARG_POINTER
+};
+
+// Largest argument payload a single record can carry, strings are truncated to fit
+const size_t LOG_PAYLOAD_SIZE = 224;
+
+class LogArgEncoder {
+	private:
+		uint8_t* payload;
+		size_t capacity;
+		size_t size = 0;
+
+		void WriteRaw(LogArgType type, const void* value, size_t length) {
+			if (size + 1 + length > capacity) {
+				return;
+			}
+			payload[size++] = type;
+			memcpy(payload + size, value, length);
+			size += length;
+		}
+
+		void WriteString(const char* text, size_t length) {
+			if (size + 3 > capacity) {
+				return;
+			}
+			length = length < capacity - size - 3 ? length : capacity - size - 3;
+			const uint16_t storedLength = static_cast<uint16_t>(length);
+			payload[size++] = LOG_ARG_STRING;
+			memcpy(payload + size, &storedLength, sizeof(storedLength));
+			size += sizeof(storedLength);
+			memcpy(payload + size, text, length);
+			size += length;
+		}
+
+	public:
+		LogArgEncoder(uint8_t* payload, size_t capacity): payload(payload), capacity(capacity) {}
+
+		size_t GetSize() const { return size; }
+
+		template <typename T>
+		void Add(const T& value) {
+			if constexpr (std::is_same<T, std::string>::value) {
+				WriteString(value.data(), value.size());
+			} else if constexpr (std::is_array<T>::value) {
+				WriteString(value, strnlen(value, sizeof(T)));
+			} else if constexpr (std::is_convertible<T, const char*>::value) {
+				const char* text = value ? static_cast<const char*>(value) : "(null)";
+				WriteString(text, strlen(text));
+			} else if constexpr (std::is_pointer<T>::value) {
+				const uint64_t address = reinterpret_cast<uintptr_t>(value);
+				WriteRaw(LOG_ARG_POINTER, &address, sizeof(address));
+			} else if constexpr (std::is_floating_point<T>::value) {
+				const double number = static_cast<double>(value);
+				WriteRaw(LOG_ARG_DOUBLE, &number, sizeof(number));
+			} else if constexpr (std::is_enum<T>::value) {
+				Add(static_cast<typename std::underlying_type<T>::type>(value));
+			} else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+				if constexpr (sizeof(T) <= 4) {
+					const int32_t number = value;
+					WriteRaw(LOG_ARG_INT32, &number, sizeof(number));
+				} else {
+					const int64_t number = value;
+					WriteRaw(LOG_ARG_INT64, &number, sizeof(number));
+				}
+			} else if constexpr (std::is_integral<T>::value) {
+				if constexpr (sizeof(T) <= 4) {
+					const uint32_t number = value;
+					WriteRaw(LOG_ARG_UINT32, &number, sizeof(number));
+				} else {
+					const uint64_t number = value;
+					WriteRaw(LOG_ARG_UINT64, &number, sizeof(number));
+				}
+			} else {
+				static_assert(std::is_arithmetic<T>::value, "Unsupported log argument type");
+			}
+		}
+
+		template <typename ...TArgs>
+		void AddAll(const TArgs&... args) {
+			(Add(args), ...);
+		}
+};
+
+// Expands a format string against an encoded payload, like snprintf. Returns the text length written.
+size_t FormatLogMessage(const char* format, const uint8_t* payload, size_t payloadSize, char* out, size_t outSize);
+
+#endif
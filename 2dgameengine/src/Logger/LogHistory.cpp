@@ -0,0 +1,111 @@
+#include "LogHistory.h"
+
+LogHistory::LogHistory(size_t capacity) {
+	records.resize(capacity > 0 ? capacity : 1);
+	for (auto& index: levelIndices) {
+		index.sequences.resize(records.size());
+	}
+}
+
+uint64_t LogHistory::OldestSequence() const {
+	return nextSequence > records.size() ? nextSequence - records.size() : 0;
+}
+
+uint64_t LogHistory::LevelSequenceAt(const LevelIndex& index, size_t position) const {
+	return index.sequences[(index.head + position) % index.sequences.size()];
+}
+
+uint32_t LogHistory::Intern(std::string_view text) {
+	auto found = internLookup.find(text);
+	if (found != internLookup.end()) {
+		internedStrings[found->second].references++;
+		return found->second;
+	}
+
+	uint32_t messageId;
+	if (!freeStringIds.empty()) {
+		messageId = freeStringIds.back();
+		freeStringIds.pop_back();
+	} else {
+		messageId = static_cast<uint32_t>(internedStrings.size());
+		internedStrings.emplace_back();
+	}
+
+	InternedString& interned = internedStrings[messageId];
+	interned.text.assign(text.data(), text.size());
+	interned.references = 1;
+	internLookup.emplace(std::string_view(interned.text), messageId);
+	return messageId;
+}
+
+void LogHistory::Release(uint32_t messageId) {
+	InternedString& interned = internedStrings[messageId];
+	if (--interned.references > 0) {
+		return;
+	}
+	internLookup.erase(std::string_view(interned.text));
+	interned.text.clear();
+	freeStringIds.push_back(messageId);
+}
+
+void LogHistory::Append(int64_t timestamp, uint8_t level, std::string_view text) {
+	if (level >= LOG_HISTORY_LEVELS) {
+		level = LOG_HISTORY_LEVELS - 1;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	LogHistoryRecord& record = records[nextSequence % records.size()];
+
+	// The slot still holds the oldest line, which is also the oldest entry of its level index
+	if (nextSequence >= records.size()) {
+		LevelIndex& evictedIndex = levelIndices[record.level];
+		evictedIndex.head = (evictedIndex.head + 1) % evictedIndex.sequences.size();
+		evictedIndex.count--;
+		Release(record.messageId);
+	}
+
+	record.sequence = nextSequence;
+	record.timestamp = timestamp;
+	record.level = level;
+	record.messageId = Intern(text);
+
+	LevelIndex& index = levelIndices[level];
+	index.sequences[(index.head + index.count) % index.sequences.size()] = nextSequence;
+	index.count++;
+
+	nextSequence++;
+}
+
+void LogHistory::Clear() {
+	std::lock_guard<std::mutex> lock(mutex);
+	nextSequence = 0;
+	for (auto& index: levelIndices) {
+		index.head = 0;
+		index.count = 0;
+	}
+	internLookup.clear();
+	internedStrings.clear();
+	freeStringIds.clear();
+}
+
+size_t LogHistory::GetCount(uint8_t levelMask) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	size_t count = 0;
+	for (int level = 0; level < LOG_HISTORY_LEVELS; level++) {
+		if (levelMask & (1 << level)) {
+			count += levelIndices[level].count;
+		}
+	}
+	return count;
+}
+
+uint64_t LogHistory::GetTotalAppended() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return nextSequence;
+}
+
+size_t LogHistory::GetInternedCount() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return internLookup.size();
+}
@@ -0,0 +1,152 @@
+#ifndef LOGHISTORY_H
+#define LOGHISTORY_H
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Number of most recent log lines kept in memory
+const size_t LOG_HISTORY_CAPACITY = 16384;
+
+// Bit per LogLevel, e.g. (1 << LOG_LEVEL_WARNING) | (1 << LOG_LEVEL_ERROR)
+const uint8_t LOG_LEVEL_MASK_ALL = 0x1F;
+const int LOG_HISTORY_LEVELS = 5;
+
+struct LogHistoryRecord {
+	uint64_t sequence;  // Position in the whole log since startup
+	int64_t timestamp;  // Wall clock, nanoseconds since the epoch
+	uint32_t messageId;
+	uint8_t level;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// LogHistory: Fixed-size ring of the latest log lines for an in-game console.
+// Message text is interned with a reference count, so a line repeated thousands of times is stored once
+// and evicted lines release their text. Each level keeps its own ring of sequence numbers so a filtered
+// page is found without scanning.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class LogHistory {
+	private:
+		struct LevelIndex {
+			std::vector<uint64_t> sequences;
+			size_t head = 0;  // Oldest entry
+			size_t count = 0;
+		};
+
+		struct InternedString {
+			std::string text;
+			uint32_t references = 0;
+		};
+
+		mutable std::mutex mutex;
+
+		std::vector<LogHistoryRecord> records;
+		uint64_t nextSequence = 0;
+		LevelIndex levelIndices[LOG_HISTORY_LEVELS];
+
+		// Keys view the text owned by internedStrings, a deque so growing it never moves them
+		std::unordered_map<std::string_view, uint32_t> internLookup;
+		std::deque<InternedString> internedStrings;
+		std::vector<uint32_t> freeStringIds;
+
+		uint32_t Intern(std::string_view text);
+		void Release(uint32_t messageId);
+		const LogHistoryRecord& RecordAt(uint64_t sequence) const { return records[sequence % records.size()]; }
+		uint64_t OldestSequence() const;
+		uint64_t LevelSequenceAt(const LevelIndex& index, size_t position) const;
+
+	public:
+		LogHistory(size_t capacity = LOG_HISTORY_CAPACITY);
+
+		// Called by the logger thread for every line written
+		void Append(int64_t timestamp, uint8_t level, std::string_view text);
+		void Clear();
+
+		// Lines currently held that match the level mask
+		size_t GetCount(uint8_t levelMask = LOG_LEVEL_MASK_ALL) const;
+
+		// Total lines ever appended, evicted ones included
+		uint64_t GetTotalAppended() const;
+
+		// Number of distinct message texts held
+		size_t GetInternedCount() const;
+
+		// Calls visitor(const LogHistoryRecord&, std::string_view text) for up to count matching lines,
+		// oldest first, starting at index first among the matching lines held. The text views are only
+		// valid inside the call, the history stays locked while it runs.
+		template <typename TVisitor>
+		void Visit(uint8_t levelMask, size_t first, size_t count, TVisitor&& visitor) const;
+};
+
+template <typename TVisitor>
+void LogHistory::Visit(uint8_t levelMask, size_t first, size_t count, TVisitor&& visitor) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	levelMask &= LOG_LEVEL_MASK_ALL;
+	if (levelMask == 0 || count == 0) {
+		return;
+	}
+
+	auto visit = [&](uint64_t sequence) {
+		const LogHistoryRecord& record = RecordAt(sequence);
+		visitor(record, std::string_view(internedStrings[record.messageId].text));
+	};
+
+	// Everything: the ring itself is the index
+	if (levelMask == LOG_LEVEL_MASK_ALL) {
+		const uint64_t oldest = OldestSequence();
+		for (uint64_t sequence = oldest + first; sequence < nextSequence && count > 0; sequence++, count--) {
+			visit(sequence);
+		}
+		return;
+	}
+
+	// A single level: direct lookup in that level's ring
+	if ((levelMask & (levelMask - 1)) == 0) {
+		int level = 0;
+		while (!(levelMask & (1 << level))) {
+			level++;
+		}
+		const LevelIndex& index = levelIndices[level];
+		for (size_t position = first; position < index.count && count > 0; position++, count--) {
+			visit(LevelSequenceAt(index, position));
+		}
+		return;
+	}
+
+	// Several levels: merge the per-level rings in sequence order
+	size_t positions[LOG_HISTORY_LEVELS] = {};
+	size_t skipped = 0;
+	while (count > 0) {
+		int nextLevel = -1;
+		uint64_t nextSequenceFound = 0;
+		for (int level = 0; level < LOG_HISTORY_LEVELS; level++) {
+			const LevelIndex& index = levelIndices[level];
+			if (!(levelMask & (1 << level)) || positions[level] >= index.count) {
+				continue;
+			}
+			uint64_t sequence = LevelSequenceAt(index, positions[level]);
+			if (nextLevel < 0 || sequence < nextSequenceFound) {
+				nextLevel = level;
+				nextSequenceFound = sequence;
+			}
+		}
+		if (nextLevel < 0) {
+			return;
+		}
+
+		positions[nextLevel]++;
+		if (skipped < first) {
+			skipped++;
+			continue;
+		}
+		visit(nextSequenceFound);
+		count--;
+	}
+}
+
+#endif
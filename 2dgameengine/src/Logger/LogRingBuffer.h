@@ -0,0 +1,90 @@
+#ifndef LOGRINGBUFFER_H
+#define LOGRINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// LogRingBuffer: Bounded lock-free multi-producer/single-consumer queue.
+// Every slot carries a sequence number telling producers and the consumer whose turn it is, so
+// producers only contend on one fetch of the write cursor and never wait on the consumer.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename T, size_t Capacity>
+class LogRingBuffer {
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+	private:
+		struct Slot {
+			std::atomic<size_t> sequence;
+			T data;
+		};
+
+		static const size_t mask = Capacity - 1;
+
+		std::unique_ptr<Slot[]> slots;
+
+		// Cursors live on their own cache lines so producers and the consumer do not false share
+		alignas(64) std::atomic<size_t> writePos;
+		alignas(64) std::atomic<size_t> readPos;
+
+	public:
+		LogRingBuffer(): slots(new Slot[Capacity]), writePos(0), readPos(0) {
+			for (size_t i = 0; i < Capacity; i++) {
+				slots[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		// Claims a slot and lets fill() write the record in place. Returns false when full.
+		template <typename TFill>
+		bool TryPush(TFill&& fill) {
+			size_t pos = writePos.load(std::memory_order_relaxed);
+			Slot* slot;
+			for (;;) {
+				slot = &slots[pos & mask];
+				size_t sequence = slot->sequence.load(std::memory_order_acquire);
+				intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+				if (diff == 0) {
+					if (writePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						break;
+					}
+				} else if (diff < 0) {
+					return false;
+				} else {
+					pos = writePos.load(std::memory_order_relaxed);
+				}
+			}
+
+			fill(slot->data);
+			slot->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer only. Hands the oldest published record to consume(), returns false when empty.
+		template <typename TConsume>
+		bool TryPop(TConsume&& consume) {
+			size_t pos = readPos.load(std::memory_order_relaxed);
+			Slot* slot = &slots[pos & mask];
+			size_t sequence = slot->sequence.load(std::memory_order_acquire);
+			if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1) < 0) {
+				return false;
+			}
+
+			consume(slot->data);
+			slot->sequence.store(pos + Capacity, std::memory_order_release);
+			readPos.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Number of records claimed so far, used to wait until everything up to a point is consumed
+		size_t GetWritePosition() const {
+			return writePos.load(std::memory_order_acquire);
+		}
+
+		size_t GetReadPosition() const {
+			return readPos.load(std::memory_order_acquire);
+		}
+};
+
+#endif
@@ -1,43 +1,237 @@
 #include "Logger.h"
-#include <iostream>
+#include "LogRingBuffer.h"
+#include <algorithm>
+#include <atomic>
 #include <chrono>
-#include <iomanip>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>
-#include <ostream>
-#include <sstream>
+#include <mutex>
+#include <thread>
 
 
-std::vector<LogEntry> Logger::messages;
+std::atomic<int> Logger::minimumLevel(LOG_COMPILE_LEVEL);
+std::atomic<int> Logger::consoleLevel(LOG_COMPILE_LEVEL);
 
 
-static std::string getCurrentTime() {
-	auto now = std::chrono::system_clock::now();
-	auto time = std::chrono::system_clock::to_time_t(now);
-	std::tm localTime = *std::localtime(&time);
+// Prefix and colour per level, indexed by LogLevel
+static const char* levelPrefixes[] = {"Trace", "Debug", "Log", "Warn", "Err"};
+static const char* levelColours[] = {"\033[90m", "\033[36m", "\033[32m", "\033[33m", "\033[31m"};
 
-	std::ostringstream oss;
-	oss << std::put_time(&localTime, "%m/%d/%Y %H:%M:%S");
-	return oss.str();
+static int64_t getCurrentTime() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
 }
 
 
-void Logger::Log(const std::string& message){
-	LogEntry logEntry;
-	logEntry.type = LOG_INFO;
-	logEntry.message = "Log: [" + getCurrentTime() + "]: " + message;
-	std::cout << "\033[32m" << logEntry.message << "\033[0m" << std::endl;
-	messages.push_back(logEntry);
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// LogBackend: Owns the queue and the thread that turns records into text.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class LogBackend {
+	private:
+		LogRingBuffer<LogRecord, LOG_QUEUE_CAPACITY> queue;
+		std::thread worker;
+		std::atomic<bool> isRunning;
+		std::atomic<unsigned long long> droppedCount;
+		std::atomic<unsigned long long> totalDropped;
+		std::atomic<size_t> flushedPos;
+		LogHistory history;
+
+		// Held by the worker while draining, so the sink can be swapped from another thread
+		std::mutex binarySinkMutex;
+		BinaryLogSink binarySink;
+
+		void Write(const LogRecord& record) {
+			if (binarySink.IsOpen()) {
+				binarySink.Write(record.level, record.format, record.timestamp, record.payload, record.payloadSize);
+			}
+
+			if (record.level < Logger::GetConsoleLevel()) {
+				return;
+			}
+
+			time_t seconds = static_cast<time_t>(record.timestamp / 1000000000LL);
+			std::tm localTime;
+			localtime_r(&seconds, &localTime);
+			char timeText[32];
+			strftime(timeText, sizeof(timeText), "%m/%d/%Y %H:%M:%S", &localTime);
+
+			char text[1024];
+			const size_t length = FormatLogMessage(record.format, record.payload, record.payloadSize, text, sizeof(text));
+
+			// No flush per line, the worker flushes once the queue runs dry
+			FILE* stream = record.level >= LOG_LEVEL_WARNING ? stderr : stdout;
+			fprintf(stream, "%s%s: [%s]: %s\033[0m\n", levelColours[record.level], levelPrefixes[record.level], timeText, text);
+
+			history.Append(record.timestamp, record.level, std::string_view(text, length));
+		}
+
+		bool Drain() {
+			const size_t readPos = queue.GetReadPosition();
+			bool wroteAny = false;
+			{
+				std::lock_guard<std::mutex> lock(binarySinkMutex);
+				while (queue.TryPop([this](const LogRecord& record) { Write(record); })) {
+					wroteAny = true;
+				}
+			}
+
+			unsigned long long dropped = droppedCount.exchange(0, std::memory_order_relaxed);
+			if (dropped > 0) {
+				fprintf(stderr, "\033[31mErr: %llu log messages dropped, queue full\033[0m\n", dropped);
+				totalDropped += dropped;
+				wroteAny = true;
+			}
+
+			if (wroteAny) {
+				fflush(stdout);
+				fflush(stderr);
+			}
+			flushedPos.store(std::max(readPos, queue.GetReadPosition()), std::memory_order_release);
+			return wroteAny;
+		}
+
+		void Run() {
+			while (isRunning.load(std::memory_order_acquire)) {
+				if (!Drain()) {
+					std::this_thread::sleep_for(std::chrono::microseconds(500));
+				}
+			}
+			Drain();
+		}
+
+	public:
+		LogBackend(): isRunning(true), droppedCount(0), totalDropped(0), flushedPos(0) {
+			worker = std::thread(&LogBackend::Run, this);
+		}
+
+		void Push(LogLevel level, const char* format, const uint8_t* payload, size_t payloadSize) {
+			const int64_t timestamp = getCurrentTime();
+			bool isQueued = queue.TryPush([&](LogRecord& record) {
+				record.timestamp = timestamp;
+				record.format = format;
+				record.level = level;
+				record.payloadSize = static_cast<uint16_t>(payloadSize);
+				memcpy(record.payload, payload, payloadSize);
+			});
+			if (!isQueued) {
+				droppedCount.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		void Flush() {
+			const size_t target = queue.GetWritePosition();
+			while (flushedPos.load(std::memory_order_acquire) < target) {
+				std::this_thread::yield();
+			}
+		}
+
+		void Shutdown() {
+			isRunning.store(false, std::memory_order_release);
+			if (worker.joinable()) {
+				worker.join();
+			}
+			CloseBinaryLog();
+		}
+
+		unsigned long long GetQueuedCount() const {
+			return queue.GetWritePosition();
+		}
+
+		unsigned long long GetDroppedCount() const {
+			return totalDropped.load(std::memory_order_relaxed) + droppedCount.load(std::memory_order_relaxed);
+		}
+
+		bool OpenBinaryLog(const std::string& filePath, size_t ringSizeBytes) {
+			std::lock_guard<std::mutex> lock(binarySinkMutex);
+			return binarySink.Open(filePath, ringSizeBytes);
+		}
+
+		void CloseBinaryLog() {
+			std::lock_guard<std::mutex> lock(binarySinkMutex);
+			binarySink.Close();
+		}
+
+		const LogHistory& GetHistory() const {
+			return history;
+		}
+};
 
+
+// Created on first use and never destroyed, so logging stays valid during static destruction.
+// At exit the worker is stopped after writing out whatever is still queued.
+static std::atomic<LogBackend*> backend(nullptr);
+static std::atomic<bool> isShutDown(false);
+static std::once_flag backendOnce;
+
+static void shutdownBackend() {
+	isShutDown.store(true, std::memory_order_release);
+	backend.load()->Shutdown();
+}
+
+static LogBackend* getBackend() {
+	std::call_once(backendOnce, []() {
+		backend.store(new LogBackend());
+		std::atexit(shutdownBackend);
+	});
+	return backend.load(std::memory_order_acquire);
+}
+
+void Logger::Push(LogLevel level, const char* format, const uint8_t* payload, size_t payloadSize) {
+	if (isShutDown.load(std::memory_order_acquire)) {
+		char text[1024];
+		FormatLogMessage(format, payload, payloadSize, text, sizeof(text));
+		fprintf(level >= LOG_LEVEL_WARNING ? stderr : stdout, "%s%s: %s\033[0m\n", levelColours[level], levelPrefixes[level], text);
+		return;
+	}
+	getBackend()->Push(level, format, payload, payloadSize);
+}
+
+void Logger::Log(const std::string& message){
+	LOG_INFO("%s", message.c_str());
 }
 
 void Logger::Err(const std::string& message){
-	LogEntry logError;
-	logError.type = LOG_ERROR;
-	logError.message = "Err: [" + getCurrentTime() + "]: " + message;
-	std::cerr << "\033[31m" << logError.message << "\033[0m" << std::endl;
-	messages.push_back(logError);
+	LOG_ERROR("%s", message.c_str());
+}
+
+void Logger::Log(const char* message){
+	LOG_INFO("%s", message);
+}
+
+void Logger::Err(const char* message){
+	LOG_ERROR("%s", message);
+}
 
+void Logger::Flush() {
+	if (!isShutDown.load(std::memory_order_acquire)) {
+		getBackend()->Flush();
+	}
+}
 
+bool Logger::OpenBinaryLog(const std::string& filePath, size_t ringSizeBytes) {
+	if (!getBackend()->OpenBinaryLog(filePath, ringSizeBytes)) {
+		LOG_ERROR("Error opening binary log %s", filePath.c_str());
+		return false;
+	}
+	return true;
+}
 
+void Logger::CloseBinaryLog() {
+	Flush();
+	getBackend()->CloseBinaryLog();
+}
 
-}
\ No newline at end of file
+const LogHistory& Logger::GetHistory() {
+	return getBackend()->GetHistory();
+}
+
+unsigned long long Logger::GetDroppedCount() {
+	return getBackend()->GetDroppedCount();
+}
+
+unsigned long long Logger::GetQueuedCount() {
+	return getBackend()->GetQueuedCount();
+}
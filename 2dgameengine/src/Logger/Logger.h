@@ -1,28 +1,141 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include "LogFormat.h"
+#include "LogHistory.h"
+#include "BinaryLogSink.h"
+#include <atomic>
+#include <cstdint>
 #include <string>
-#include <vector>
 
-enum LogType {
-	LOG_INFO,
-	LOG_WARNING,
-	LOG_ERROR
+enum LogLevel : uint8_t {
+	LOG_LEVEL_TRACE = 0,
+	LOG_LEVEL_DEBUG = 1,
+	LOG_LEVEL_INFO = 2,
+	LOG_LEVEL_WARNING = 3,
+	LOG_LEVEL_ERROR = 4
 };
 
-struct LogEntry {
-	LogType type;
-	std::string message;
+// Log calls below this level are removed at compile time: 0 trace, 1 debug, 2 info, 3 warning, 4 error.
+// Release builds can pass e.g. -DLOG_COMPILE_LEVEL=2 to strip trace and debug entirely.
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 1
+#endif
+
+// Records in flight between callers and the logger thread, must be a power of two
+const size_t LOG_QUEUE_CAPACITY = 8192;
+
+// Fixed-size record handed from the calling thread to the logger thread. The format string is a
+// literal so only its address is stored, arguments stay raw until the logger thread formats them.
+struct LogRecord {
+	int64_t timestamp;  // Wall clock, nanoseconds since the epoch
+	const char* format;
+	LogLevel level;
+	uint16_t payloadSize;
+	uint8_t payload[LOG_PAYLOAD_SIZE];
 };
 
+#if defined(__GNUC__)
+#define LOG_PRINTF_FORMAT(formatIndex, firstArgIndex) __attribute__((format(printf, formatIndex, firstArgIndex)))
+#else
+#define LOG_PRINTF_FORMAT(formatIndex, firstArgIndex)
+#endif
+
 class Logger {
+	private:
+		static std::atomic<int> minimumLevel;
+		static std::atomic<int> consoleLevel;
+
+		static void Push(LogLevel level, const char* format, const uint8_t* payload, size_t payloadSize);
+
 	public:
-		static std::vector<LogEntry> messages; 
+		// Runtime filter on top of LOG_COMPILE_LEVEL
+		static void SetLevel(LogLevel level) { minimumLevel.store(level, std::memory_order_relaxed); }
+		static LogLevel GetLevel() { return static_cast<LogLevel>(minimumLevel.load(std::memory_order_relaxed)); }
+		static bool IsEnabled(LogLevel level) { return level >= minimumLevel.load(std::memory_order_relaxed); }
+
+		// Lines below this level still reach the binary log but skip the console and the history,
+		// e.g. SetLevel(LOG_LEVEL_TRACE) with SetConsoleLevel(LOG_LEVEL_INFO) for production tracing
+		static void SetConsoleLevel(LogLevel level) { consoleLevel.store(level, std::memory_order_relaxed); }
+		static LogLevel GetConsoleLevel() { return static_cast<LogLevel>(consoleLevel.load(std::memory_order_relaxed)); }
+
+		// Mirrors every captured record into a memory-mapped ring file, see tools/LogDecoder
+		static bool OpenBinaryLog(const std::string& filePath, size_t ringSizeBytes = 64 * 1024 * 1024);
+		static void CloseBinaryLog();
+
+		// Captures the arguments as raw values, formatting happens on the logger thread.
+		// Use the LOG_* macros so the format string is checked and disabled levels compile away.
+		template <typename ...TArgs>
+		static void Write(LogLevel level, const char* format, const TArgs&... args) {
+			uint8_t payload[LOG_PAYLOAD_SIZE];
+			LogArgEncoder encoder(payload, sizeof(payload));
+			encoder.AddAll(args...);
+			Push(level, format, payload, encoder.GetSize());
+		}
+
+		// Never called, only gives the compiler a printf signature to check LOG_* arguments against
+		static void CheckFormat(const char*, ...) LOG_PRINTF_FORMAT(1, 2) {}
+
 		static void Log(const std::string& message);
 		static void Err(const std::string& message);
 
+		// Literal messages skip the temporary std::string and its heap allocation
+		static void Log(const char* message);
+		static void Err(const char* message);
+
+		// Blocks until every record queued before the call has been written out
+		static void Flush();
+
+		// Bounded history of the latest lines written, for the in-game console
+		static const LogHistory& GetHistory();
+
+		// Records thrown away because the queue was full
+		static unsigned long long GetDroppedCount();
+
+		// Records accepted into the queue since startup, sampled over time it gives the log throughput
+		static unsigned long long GetQueuedCount();
 };
 
+#define LOG_AT_LEVEL(level, format, ...) \
+	do { \
+		if (false) { \
+			Logger::CheckFormat(format, ##__VA_ARGS__); \
+		} \
+		if (Logger::IsEnabled(level)) { \
+			Logger::Write(level, "" format, ##__VA_ARGS__); \
+		} \
+	} while (0)
+
+#if LOG_COMPILE_LEVEL <= 0
+#define LOG_TRACE(format, ...) LOG_AT_LEVEL(LOG_LEVEL_TRACE, format, ##__VA_ARGS__)
+#else
+#define LOG_TRACE(format, ...) ((void)0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= 1
+#define LOG_DEBUG(format, ...) LOG_AT_LEVEL(LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(format, ...) ((void)0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= 2
+#define LOG_INFO(format, ...) LOG_AT_LEVEL(LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+#else
+#define LOG_INFO(format, ...) ((void)0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= 3
+#define LOG_WARN(format, ...) LOG_AT_LEVEL(LOG_LEVEL_WARNING, format, ##__VA_ARGS__)
+#else
+#define LOG_WARN(format, ...) ((void)0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= 4
+#define LOG_ERROR(format, ...) LOG_AT_LEVEL(LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(format, ...) ((void)0)
+#endif
+
 
 
 
@@ -37,4 +150,4 @@ class Logger {
 
 
 
-#endif
\ No newline at end of file
+#endif
@@ -1,11 +1,77 @@
 #include "./Game/Game.h"
+#include "./Profiler/AllocationTracker.h"
+#include <cstdlib>
+#include <cstring>
 
 
 int main(int argc, char* argv[]) {
     Game game;
 
-    game.Initialize();
-    game.Run();
+    RenderMode renderMode = RENDER_WINDOW;
+    unsigned long long maxFrames = 0;
+    bool isStressTest = false;
+    StressTestConfig stressTest;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            renderMode = RENDER_HEADLESS;
+        } else if (strcmp(argv[i], "--offscreen") == 0) {
+            renderMode = RENDER_OFFSCREEN;
+        } else if (strcmp(argv[i], "--unlocked") == 0) {
+            game.SetTargetFps(0.0);
+        } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            game.SetTargetFps(atof(argv[++i]));
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            game.SetTraceFile(argv[++i]);
+        } else if (strcmp(argv[i], "--assert-no-alloc") == 0 && i + 1 < argc) {
+            // Abort on the first frame that allocates after this many warm-up frames
+            AllocationTracker::SetZeroAllocationAssert(strtoull(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--lua-gc-budget") == 0 && i + 1 < argc) {
+            // Microseconds of Lua garbage collection per frame
+            game.SetScriptGcBudget(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--lua-memory-cap") == 0 && i + 1 < argc) {
+            // Megabytes, zero for no cap
+            game.SetScriptMemoryCap(strtoull(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--no-script-cache") == 0) {
+            game.SetScriptCacheDirectory("");
+        } else if (strcmp(argv[i], "--lua-profile") == 0 && i + 1 < argc) {
+            // Folded stacks for flamegraph.pl, per-line times go to the same path plus .lines
+            game.SetScriptProfile(argv[++i], false);
+        } else if (strcmp(argv[i], "--lua-profile-lines") == 0 && i + 1 < argc) {
+            // Times every executed line instead of sampling, much slower
+            game.SetScriptProfile(argv[++i], true);
+        } else if (strcmp(argv[i], "--script-workers") == 0 && i + 1 < argc) {
+            game.SetScriptWorkers(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            maxFrames = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--stress") == 0) {
+            isStressTest = true;
+        } else if (strcmp(argv[i], "--tanks") == 0 && i + 1 < argc) {
+            stressTest.numTanks = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--trucks") == 0 && i + 1 < argc) {
+            stressTest.numTrucks = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--choppers") == 0 && i + 1 < argc) {
+            stressTest.numChoppers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bullets") == 0 && i + 1 < argc) {
+            stressTest.numBullets = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--scripted") == 0 && i + 1 < argc) {
+            stressTest.numScripted = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            stressTest.seed = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            stressTest.warmupFrames = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--report") == 0 && i + 1 < argc) {
+            stressTest.reportPath = argv[++i];
+        }
+    }
+
+    // Stress test options only take effect together with --stress
+    if (isStressTest) {
+        game.SetStressTest(stressTest);
+    }
+
+    game.Initialize(renderMode);
+    game.Run(maxFrames);
     game.Destroy();
 
     return 0;
@@ -0,0 +1,205 @@
+#include "AllocationTracker.h"
+#include "Profiler.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+	// Plain atomics in static storage so the hooks below work before main and after exit
+	struct ThreadSlot {
+		std::atomic<uint64_t> allocations;
+		std::atomic<uint64_t> frees;
+		std::atomic<uint64_t> allocatedBytes;
+	};
+
+	ThreadSlot slots[ALLOCATION_TRACKER_MAX_THREADS];
+	std::atomic<uint32_t> slotsInUse(0);
+	thread_local ThreadSlot* threadSlot = nullptr;
+
+	// Frame bookkeeping, only touched by the thread calling Profiler::BeginFrame
+	AllocationStats frameStartThread;
+	AllocationStats frameStartProcess;
+	AllocationStats lastFrameThread;
+	AllocationStats lastFrameProcess;
+	std::atomic<uint64_t> assertAfterFrame(0);
+
+	ThreadSlot& GetThreadSlot() {
+		if (!threadSlot) {
+			uint32_t index = slotsInUse.fetch_add(1, std::memory_order_relaxed);
+			if (index >= ALLOCATION_TRACKER_MAX_THREADS) {
+				index = ALLOCATION_TRACKER_MAX_THREADS - 1;
+			}
+			threadSlot = &slots[index];
+		}
+		return *threadSlot;
+	}
+
+	AllocationStats ReadSlot(const ThreadSlot& slot) {
+		AllocationStats stats;
+		stats.allocations = slot.allocations.load(std::memory_order_relaxed);
+		stats.frees = slot.frees.load(std::memory_order_relaxed);
+		stats.allocatedBytes = slot.allocatedBytes.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	AllocationStats GetProcessStats() {
+		AllocationStats total;
+		const uint32_t count = std::min<uint32_t>(slotsInUse.load(std::memory_order_relaxed), ALLOCATION_TRACKER_MAX_THREADS);
+		for (uint32_t i = 0; i < count; i++) {
+			const AllocationStats stats = ReadSlot(slots[i]);
+			total.allocations += stats.allocations;
+			total.frees += stats.frees;
+			total.allocatedBytes += stats.allocatedBytes;
+		}
+		return total;
+	}
+
+	AllocationStats Subtract(const AllocationStats& end, const AllocationStats& start) {
+		AllocationStats delta;
+		delta.allocations = end.allocations - start.allocations;
+		delta.frees = end.frees - start.frees;
+		delta.allocatedBytes = end.allocatedBytes - start.allocatedBytes;
+		return delta;
+	}
+}
+
+bool AllocationTracker::IsEnabled() {
+#ifdef ENGINE_ALLOC_TRACKING
+	return true;
+#else
+	return false;
+#endif
+}
+
+void AllocationTracker::RecordAllocation(size_t bytes) {
+	ThreadSlot& slot = GetThreadSlot();
+	slot.allocations.fetch_add(1, std::memory_order_relaxed);
+	slot.allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void AllocationTracker::RecordFree() {
+	GetThreadSlot().frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+AllocationStats AllocationTracker::GetThreadStats() {
+	return ReadSlot(GetThreadSlot());
+}
+
+void AllocationTracker::GetAllThreadStats(std::vector<AllocationStats>& stats) {
+	const uint32_t count = std::min<uint32_t>(slotsInUse.load(std::memory_order_relaxed), ALLOCATION_TRACKER_MAX_THREADS);
+	stats.resize(count);
+	for (uint32_t i = 0; i < count; i++) {
+		stats[i] = ReadSlot(slots[i]);
+	}
+}
+
+void AllocationTracker::BeginFrame() {
+	const AllocationStats thread = GetThreadStats();
+	const AllocationStats process = GetProcessStats();
+	lastFrameThread = Subtract(thread, frameStartThread);
+	lastFrameProcess = Subtract(process, frameStartProcess);
+	frameStartThread = thread;
+	frameStartProcess = process;
+}
+
+void AllocationTracker::CheckFrame(uint64_t frameIndex) {
+	const uint64_t afterFrame = assertAfterFrame.load(std::memory_order_relaxed);
+	if (afterFrame == 0 || frameIndex < afterFrame || lastFrameThread.allocations == 0) {
+		return;
+	}
+
+	LOG_ERROR("Frame %llu made %llu allocations (%llu bytes) in steady state",
+		static_cast<unsigned long long>(frameIndex - 1),
+		static_cast<unsigned long long>(lastFrameThread.allocations),
+		static_cast<unsigned long long>(lastFrameThread.allocatedBytes));
+
+	std::vector<ProfileScopeTotal> scopes;
+	Profiler::GetLastFrameScopes(scopes);
+	for (const auto& scope: scopes) {
+		if (scope.allocations > 0) {
+			LOG_ERROR("  %s: %llu allocations, %llu bytes", scope.name,
+				static_cast<unsigned long long>(scope.allocations),
+				static_cast<unsigned long long>(scope.allocatedBytes));
+		}
+	}
+
+	Logger::Flush();
+	abort();
+}
+
+AllocationStats AllocationTracker::GetLastFrameStats() {
+	return lastFrameThread;
+}
+
+AllocationStats AllocationTracker::GetLastFrameProcessStats() {
+	return lastFrameProcess;
+}
+
+void AllocationTracker::SetZeroAllocationAssert(uint64_t afterFrame) {
+	assertAfterFrame.store(afterFrame, std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Global operator new/delete replacements, only in ENGINE_ALLOC_TRACKING builds
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef ENGINE_ALLOC_TRACKING
+
+namespace {
+	void* TrackedAllocate(size_t size) {
+		void* pointer = malloc(size == 0 ? 1 : size);
+		if (!pointer) {
+			throw std::bad_alloc();
+		}
+		AllocationTracker::RecordAllocation(size);
+		return pointer;
+	}
+
+	void* TrackedAllocateAligned(size_t size, std::align_val_t alignment) {
+		void* pointer = nullptr;
+		if (posix_memalign(&pointer, static_cast<size_t>(alignment), size == 0 ? 1 : size) != 0) {
+			throw std::bad_alloc();
+		}
+		AllocationTracker::RecordAllocation(size);
+		return pointer;
+	}
+
+	void TrackedFree(void* pointer) {
+		if (pointer) {
+			AllocationTracker::RecordFree();
+			free(pointer);
+		}
+	}
+}
+
+void* operator new(size_t size) { return TrackedAllocate(size); }
+void* operator new[](size_t size) { return TrackedAllocate(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return TrackedAllocateAligned(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return TrackedAllocateAligned(size, alignment); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	void* pointer = malloc(size == 0 ? 1 : size);
+	if (pointer) {
+		AllocationTracker::RecordAllocation(size);
+	}
+	return pointer;
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+	return operator new(size, tag);
+}
+
+void operator delete(void* pointer) noexcept { TrackedFree(pointer); }
+void operator delete[](void* pointer) noexcept { TrackedFree(pointer); }
+void operator delete(void* pointer, size_t) noexcept { TrackedFree(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { TrackedFree(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { TrackedFree(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { TrackedFree(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { TrackedFree(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { TrackedFree(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept { TrackedFree(pointer); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept { TrackedFree(pointer); }
+
+#endif
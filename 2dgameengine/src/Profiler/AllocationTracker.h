@@ -0,0 +1,53 @@
+#ifndef ALLOCATIONTRACKER_H
+#define ALLOCATIONTRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Threads with a counter slot of their own, any further threads share the last one
+const size_t ALLOCATION_TRACKER_MAX_THREADS = 64;
+
+struct AllocationStats {
+	uint64_t allocations = 0;
+	uint64_t frees = 0;
+	uint64_t allocatedBytes = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AllocationTracker: Counts heap allocations per thread. Built with -DENGINE_ALLOC_TRACKING (make
+// ALLOC_TRACKING=1) it replaces the global operator new/delete. Every profiler scope then reports the
+// allocations made inside it, and each frame is totalled for the thread that drives the frames. Engine
+// allocators that bypass operator new report through RecordAllocation/RecordFree. Without the flag every
+// count stays at zero.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class AllocationTracker {
+	public:
+		static bool IsEnabled();
+
+		// Safe to call from inside an allocator: no locks, no allocations and no logging
+		static void RecordAllocation(size_t bytes);
+		static void RecordFree();
+
+		// Running totals of the calling thread
+		static AllocationStats GetThreadStats();
+
+		// Running totals of every thread that ever allocated, one entry per slot in use
+		static void GetAllThreadStats(std::vector<AllocationStats>& stats);
+
+		// Called by Profiler::BeginFrame on the frame thread: closes the previous frame, then once the profiler
+		// has published that frame's scopes, checks it against the zero allocation assert
+		static void BeginFrame();
+		static void CheckFrame(uint64_t frameIndex);
+
+		// Allocations of the last finished frame on the frame thread, and on every thread together
+		static AllocationStats GetLastFrameStats();
+		static AllocationStats GetLastFrameProcessStats();
+
+		// Steady state check: from frame afterFrame on, a frame that allocates on the frame thread logs the
+		// offending profiler scopes and aborts. Zero turns the check off.
+		static void SetZeroAllocationAssert(uint64_t afterFrame);
+};
+
+#endif
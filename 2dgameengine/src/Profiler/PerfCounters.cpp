@@ -0,0 +1,153 @@
+#include "PerfCounters.h"
+#include "../Logger/Logger.h"
+#include <atomic>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace {
+	const char* counterNames[PERF_COUNTER_COUNT] = {"cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"};
+
+#ifdef __linux__
+	struct CounterConfig {
+		uint32_t type;
+		uint64_t config;
+	};
+
+	const CounterConfig counterConfigs[PERF_COUNTER_COUNT] = {
+		{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+		{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+		{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+		{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+		{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+	};
+
+	// Only the first failure is worth a log line, every thread would hit the same one
+	std::atomic<bool> hasLoggedFailure(false);
+
+	struct ThreadCounters {
+		bool isOpened = false;
+		int leaderFd = -1;
+		int fds[PERF_COUNTER_COUNT] = {-1, -1, -1, -1, -1};
+		uint64_t ids[PERF_COUNTER_COUNT] = {};
+
+		~ThreadCounters() {
+			for (int fd: fds) {
+				if (fd >= 0) {
+					close(fd);
+				}
+			}
+		}
+
+		int OpenCounter(PerfCounterType type, int groupFd) {
+			perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = counterConfigs[type].type;
+			attr.config = counterConfigs[type].config;
+			attr.disabled = groupFd < 0 ? 1 : 0;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID;
+			return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+		}
+
+		void Open() {
+			isOpened = true;
+
+			leaderFd = OpenCounter(PERF_CYCLES, -1);
+			if (leaderFd < 0) {
+				if (!hasLoggedFailure.exchange(true)) {
+					LOG_WARN("Hardware counters unavailable, perf_event_open failed: %s", strerror(errno));
+				}
+				return;
+			}
+			fds[PERF_CYCLES] = leaderFd;
+
+			for (int type = PERF_CYCLES + 1; type < PERF_COUNTER_COUNT; type++) {
+				fds[type] = OpenCounter(static_cast<PerfCounterType>(type), leaderFd);
+				if (fds[type] < 0 && !hasLoggedFailure.exchange(true)) {
+					LOG_WARN("Hardware counter %s unavailable: %s", counterNames[type], strerror(errno));
+				}
+			}
+
+			for (int type = 0; type < PERF_COUNTER_COUNT; type++) {
+				if (fds[type] >= 0) {
+					ioctl(fds[type], PERF_EVENT_IOC_ID, &ids[type]);
+				}
+			}
+
+			ioctl(leaderFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+			ioctl(leaderFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+		}
+
+		bool Read(PerfCounterValues& values) {
+			// Layout for PERF_FORMAT_GROUP | PERF_FORMAT_ID: count, then a {value, id} pair per member
+			struct {
+				uint64_t count;
+				struct {
+					uint64_t value;
+					uint64_t id;
+				} entries[PERF_COUNTER_COUNT];
+			} group;
+
+			if (read(leaderFd, &group, sizeof(group)) <= 0) {
+				return false;
+			}
+
+			for (uint64_t i = 0; i < group.count && i < PERF_COUNTER_COUNT; i++) {
+				for (int type = 0; type < PERF_COUNTER_COUNT; type++) {
+					if (fds[type] >= 0 && ids[type] == group.entries[i].id) {
+						values.values[type] = group.entries[i].value;
+					}
+				}
+			}
+			return true;
+		}
+	};
+
+	ThreadCounters& GetThreadCounters() {
+		thread_local ThreadCounters counters;
+		if (!counters.isOpened) {
+			counters.Open();
+		}
+		return counters;
+	}
+#endif
+}
+
+bool PerfCounters::IsAvailable() {
+#ifdef __linux__
+	return GetThreadCounters().leaderFd >= 0;
+#else
+	return false;
+#endif
+}
+
+bool PerfCounters::IsCounterAvailable(PerfCounterType type) {
+#ifdef __linux__
+	return GetThreadCounters().fds[type] >= 0;
+#else
+	return false;
+#endif
+}
+
+bool PerfCounters::Read(PerfCounterValues& values) {
+	values = PerfCounterValues();
+#ifdef __linux__
+	ThreadCounters& counters = GetThreadCounters();
+	return counters.leaderFd >= 0 && counters.Read(values);
+#else
+	return false;
+#endif
+}
+
+const char* PerfCounters::GetName(PerfCounterType type) {
+	return counterNames[type];
+}
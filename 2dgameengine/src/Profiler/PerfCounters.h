@@ -0,0 +1,41 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <cstdint>
+
+enum PerfCounterType {
+	PERF_CYCLES,
+	PERF_INSTRUCTIONS,
+	PERF_L1D_MISSES,
+	PERF_LLC_MISSES,
+	PERF_BRANCH_MISSES,
+	PERF_COUNTER_COUNT
+};
+
+// Raw user space counts, a counter the CPU or kernel doesn't offer stays at zero
+struct PerfCounterValues {
+	uint64_t values[PERF_COUNTER_COUNT] = {};
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PerfCounters: Hardware performance counters for the calling thread through perf_event_open, Linux only.
+// All counters are opened as one group so a single read returns a consistent snapshot. Elsewhere, or when the
+// kernel refuses (perf_event_paranoid, containers, VMs without a virtual PMU), IsAvailable returns false and
+// reads return zeros.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class PerfCounters {
+	public:
+		// Opens the group for the calling thread on first use, true when at least the cycle counter works
+		static bool IsAvailable();
+
+		// Which counters of the group actually opened on this thread
+		static bool IsCounterAvailable(PerfCounterType type);
+
+		// Running totals for the calling thread since its group was opened
+		static bool Read(PerfCounterValues& values);
+
+		static const char* GetName(PerfCounterType type);
+};
+
+#endif
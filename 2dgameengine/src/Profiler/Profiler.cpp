@@ -0,0 +1,274 @@
+#include "Profiler.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+	struct ThreadBuffer {
+		uint32_t threadId;
+		std::string name;
+		uint32_t depth = 0;
+
+		// Written by the owning thread, read by exports from any thread
+		std::mutex mutex;
+		std::vector<ProfileEvent> events;
+		uint64_t writeIndex = 0;
+
+		// Running totals of the current frame, a handful of names so a linear search is fine
+		std::vector<ProfileScopeTotal> frameTotals;
+
+		ThreadBuffer(uint32_t threadId): threadId(threadId) {
+			events.resize(PROFILER_EVENTS_PER_THREAD);
+		}
+	};
+
+	struct ProfilerState {
+		std::mutex mutex;
+		std::vector<std::shared_ptr<ThreadBuffer>> threads;
+
+		// Ring of frame start times, written by the thread that calls BeginFrame
+		std::vector<int64_t> frameStarts = std::vector<int64_t>(PROFILER_MAX_FRAMES);
+		uint64_t frameIndex = 0;
+
+		// Totals of the last finished frame, published by BeginFrame
+		std::vector<ProfileScopeTotal> lastFrameTotals;
+	};
+
+	std::atomic<bool> isEnabled(true);
+	std::atomic<uint32_t> nextThreadId(1);
+
+	ProfilerState& GetState() {
+		static ProfilerState* state = new ProfilerState();
+		return *state;
+	}
+
+	ThreadBuffer& GetThreadBuffer() {
+		// Buffers are shared with the state so events outlive the thread that recorded them
+		thread_local std::shared_ptr<ThreadBuffer> buffer;
+		if (!buffer) {
+			buffer = std::make_shared<ThreadBuffer>(nextThreadId.fetch_add(1));
+			buffer->name = "Thread " + std::to_string(buffer->threadId);
+			ProfilerState& state = GetState();
+			std::lock_guard<std::mutex> lock(state.mutex);
+			state.threads.push_back(buffer);
+		}
+		return *buffer;
+	}
+
+	// Entry of the current frame for name, created empty on first use
+	ProfileScopeTotal& GetFrameTotal(ThreadBuffer& buffer, const char* name) {
+		for (auto& total: buffer.frameTotals) {
+			if (total.name == name) {
+				return total;
+			}
+		}
+		ProfileScopeTotal total;
+		total.name = name;
+		total.firstStart = INT64_MAX;
+		total.totalNanos = 0;
+		total.calls = 0;
+		total.depth = UINT32_MAX;
+		total.allocations = 0;
+		total.allocatedBytes = 0;
+		total.hasCounters = false;
+		buffer.frameTotals.push_back(total);
+		return buffer.frameTotals.back();
+	}
+
+	void WriteJsonString(FILE* file, const char* text) {
+		fputc('"', file);
+		for (const char* c = text; *c; c++) {
+			if (*c == '"' || *c == '\\') {
+				fputc('\\', file);
+			}
+			fputc(static_cast<unsigned char>(*c) < 0x20 ? ' ' : *c, file);
+		}
+		fputc('"', file);
+	}
+}
+
+int64_t Profiler::Now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::SetEnabled(bool enabled) {
+	isEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Profiler::IsEnabled() {
+	return isEnabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::SetThreadName(const std::string& name) {
+	ThreadBuffer& buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	buffer.name = name;
+}
+
+uint32_t Profiler::PushDepth() {
+	return GetThreadBuffer().depth++;
+}
+
+void Profiler::PopDepth() {
+	GetThreadBuffer().depth--;
+}
+
+void Profiler::Record(const char* name, int64_t start, int64_t end, uint32_t depth, uint64_t allocations, uint64_t allocatedBytes) {
+	ThreadBuffer& buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	buffer.events[buffer.writeIndex % buffer.events.size()] = {name, start, end, depth};
+	buffer.writeIndex++;
+
+	ProfileScopeTotal& total = GetFrameTotal(buffer, name);
+	total.firstStart = std::min(total.firstStart, start);
+	total.totalNanos += end - start;
+	total.calls++;
+	total.depth = std::min(total.depth, depth);
+	total.allocations += allocations;
+	total.allocatedBytes += allocatedBytes;
+}
+
+void Profiler::RecordCounters(const char* name, const PerfCounterValues& delta) {
+	ThreadBuffer& buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	ProfileScopeTotal& total = GetFrameTotal(buffer, name);
+	for (int type = 0; type < PERF_COUNTER_COUNT; type++) {
+		total.counters.values[type] += delta.values[type];
+	}
+	total.hasCounters = true;
+}
+
+void Profiler::RecordTotal(const char* name, int64_t firstStart, int64_t totalNanos, uint32_t calls, uint32_t depth) {
+	ThreadBuffer& buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	ProfileScopeTotal& total = GetFrameTotal(buffer, name);
+	total.firstStart = std::min(total.firstStart, firstStart);
+	total.totalNanos += totalNanos;
+	total.calls += calls;
+	total.depth = std::min(total.depth, depth);
+}
+
+void Profiler::BeginFrame() {
+	ProfilerState& state = GetState();
+	ThreadBuffer& buffer = GetThreadBuffer();
+	const int64_t now = Now();
+
+	AllocationTracker::BeginFrame();
+	const AllocationStats frameAllocations = AllocationTracker::GetLastFrameStats();
+
+	uint64_t frameIndex;
+	{
+		std::lock_guard<std::mutex> lock(state.mutex);
+		if (state.frameIndex > 0 && IsEnabled()) {
+			const int64_t previousStart = state.frameStarts[(state.frameIndex - 1) % state.frameStarts.size()];
+			Record("Frame", previousStart, now, 0, frameAllocations.allocations, frameAllocations.allocatedBytes);
+		}
+		frameIndex = state.frameIndex++;
+		state.frameStarts[frameIndex % state.frameStarts.size()] = now;
+
+		// Copied rather than swapped so both vectors keep their capacity from frame to frame
+		{
+			std::lock_guard<std::mutex> bufferLock(buffer.mutex);
+			state.lastFrameTotals.assign(buffer.frameTotals.begin(), buffer.frameTotals.end());
+			buffer.frameTotals.clear();
+		}
+		std::sort(state.lastFrameTotals.begin(), state.lastFrameTotals.end(), [](const ProfileScopeTotal& a, const ProfileScopeTotal& b) {
+			return a.firstStart < b.firstStart;
+		});
+	}
+
+	AllocationTracker::CheckFrame(frameIndex);
+}
+
+uint64_t Profiler::GetFrameIndex() {
+	ProfilerState& state = GetState();
+	std::lock_guard<std::mutex> lock(state.mutex);
+	return state.frameIndex;
+}
+
+void Profiler::GetLastFrameScopes(std::vector<ProfileScopeTotal>& totals) {
+	ProfilerState& state = GetState();
+	std::lock_guard<std::mutex> lock(state.mutex);
+	totals.assign(state.lastFrameTotals.begin(), state.lastFrameTotals.end());
+}
+
+void Profiler::GetFrameTimes(std::vector<int64_t>& frameNanos, size_t maxFrames) {
+	ProfilerState& state = GetState();
+	std::lock_guard<std::mutex> lock(state.mutex);
+
+	// N held starts give N - 1 finished frames
+	const size_t held = std::min<size_t>(state.frameIndex, state.frameStarts.size());
+	const size_t count = held > 0 ? std::min(maxFrames, held - 1) : 0;
+	frameNanos.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		const uint64_t frame = state.frameIndex - count - 1 + i;
+		frameNanos[i] = state.frameStarts[(frame + 1) % state.frameStarts.size()] - state.frameStarts[frame % state.frameStarts.size()];
+	}
+}
+
+bool Profiler::ExportChromeTrace(const std::string& filePath, size_t lastFrames) {
+	ProfilerState& state = GetState();
+
+	std::vector<std::shared_ptr<ThreadBuffer>> threads;
+	int64_t since = INT64_MIN;
+	{
+		std::lock_guard<std::mutex> lock(state.mutex);
+		threads = state.threads;
+
+		if (lastFrames > 0 && state.frameIndex > 0) {
+			lastFrames = std::min<size_t>({lastFrames, state.frameStarts.size(), state.frameIndex});
+			since = state.frameStarts[(state.frameIndex - lastFrames) % state.frameStarts.size()];
+		}
+	}
+
+	FILE* file = fopen(filePath.c_str(), "w");
+	if (!file) {
+		LOG_ERROR("Error opening trace file %s", filePath.c_str());
+		return false;
+	}
+
+	fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	bool isFirst = true;
+	size_t eventCount = 0;
+
+	for (auto& thread: threads) {
+		std::vector<ProfileEvent> events;
+		std::string threadName;
+		{
+			std::lock_guard<std::mutex> lock(thread->mutex);
+			const uint64_t held = std::min<uint64_t>(thread->writeIndex, thread->events.size());
+			for (uint64_t i = thread->writeIndex - held; i < thread->writeIndex; i++) {
+				const ProfileEvent& event = thread->events[i % thread->events.size()];
+				if (event.start >= since) {
+					events.push_back(event);
+				}
+			}
+			threadName = thread->name;
+		}
+
+		fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", isFirst ? "" : ",\n", thread->threadId);
+		WriteJsonString(file, threadName.c_str());
+		fprintf(file, "}}");
+		isFirst = false;
+
+		for (const auto& event: events) {
+			fprintf(file, ",\n{\"ph\":\"X\",\"cat\":\"engine\",\"name\":");
+			WriteJsonString(file, event.name);
+			fprintf(file, ",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				thread->threadId, event.start / 1000.0, (event.end - event.start) / 1000.0);
+		}
+		eventCount += events.size();
+	}
+
+	fprintf(file, "\n]}\n");
+	fclose(file);
+
+	LOG_INFO("Exported %zu profiler events to %s", eventCount, filePath.c_str());
+	return true;
+}
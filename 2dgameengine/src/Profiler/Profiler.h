@@ -0,0 +1,164 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "AllocationTracker.h"
+#include "PerfCounters.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Events kept per thread, older ones are overwritten
+const size_t PROFILER_EVENTS_PER_THREAD = 65536;
+
+// Frame boundaries kept for "last N frames" exports
+const size_t PROFILER_MAX_FRAMES = 600;
+
+struct ProfileEvent {
+	const char* name;  // Must outlive the profiler, string literals in practice
+	int64_t start;     // Nanoseconds on the profiler clock
+	int64_t end;
+	uint32_t depth;    // Nesting level on its thread, 0 for outermost scopes
+};
+
+// Time spent in one scope name over a whole frame, summed across calls
+struct ProfileScopeTotal {
+	const char* name;
+	int64_t firstStart;  // Start of the first call, used to keep scopes in execution order
+	int64_t totalNanos;
+	uint32_t calls;
+	uint32_t depth;      // Shallowest depth of any call
+
+	// Heap allocations made inside the scope, children included, in ENGINE_ALLOC_TRACKING builds
+	uint64_t allocations;
+	uint64_t allocatedBytes;
+
+	// Hardware counter deltas, only for PROFILE_SYSTEM scopes in PROFILER_PERF_COUNTERS builds
+	bool hasCounters;
+	PerfCounterValues counters;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Profiler: Collects nested timed scopes into per-thread ring buffers and exports them as Chrome
+// Trace Event JSON, which loads in chrome://tracing and Perfetto.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class Profiler {
+	public:
+		// Monotonic nanoseconds
+		static int64_t Now();
+
+		// Marks the start of a new frame on the calling thread, the previous one becomes a "Frame" event
+		static void BeginFrame();
+		static uint64_t GetFrameIndex();
+
+		static void SetEnabled(bool isEnabled);
+		static bool IsEnabled();
+
+		// Name shown for the calling thread in the trace viewer
+		static void SetThreadName(const std::string& name);
+
+		// Called by ProfileScope, records one finished scope on the calling thread
+		static void Record(const char* name, int64_t start, int64_t end, uint32_t depth,
+			uint64_t allocations = 0, uint64_t allocatedBytes = 0);
+		static void RecordCounters(const char* name, const PerfCounterValues& delta);
+		// Adds time measured some other way than a scope, e.g. by sampling, to this frame's totals on the
+		// calling thread. No trace event is written, since there is no single interval to show
+		static void RecordTotal(const char* name, int64_t firstStart, int64_t totalNanos, uint32_t calls, uint32_t depth);
+		static uint32_t PushDepth();
+		static void PopDepth();
+
+		// Per scope totals of the last finished frame on the thread that calls BeginFrame
+		static void GetLastFrameScopes(std::vector<ProfileScopeTotal>& totals);
+
+		// Durations of up to maxFrames finished frames in nanoseconds, oldest first
+		static void GetFrameTimes(std::vector<int64_t>& frameNanos, size_t maxFrames = PROFILER_MAX_FRAMES);
+
+		// Writes every event still held, or only those of the last lastFrames frames when non-zero
+		static bool ExportChromeTrace(const std::string& filePath, size_t lastFrames = 0);
+};
+
+// Times the enclosing block, see PROFILE_SCOPE
+class ProfileScope {
+	private:
+		const char* name;
+		int64_t start;
+		uint32_t depth;
+		bool isActive;
+#ifdef ENGINE_ALLOC_TRACKING
+		AllocationStats startAllocations;
+#endif
+
+	public:
+		ProfileScope(const char* name): name(name), start(0), depth(0), isActive(Profiler::IsEnabled()) {
+			if (isActive) {
+				depth = Profiler::PushDepth();
+#ifdef ENGINE_ALLOC_TRACKING
+				startAllocations = AllocationTracker::GetThreadStats();
+#endif
+				start = Profiler::Now();
+			}
+		}
+
+		~ProfileScope() {
+			if (isActive) {
+				const int64_t end = Profiler::Now();
+#ifdef ENGINE_ALLOC_TRACKING
+				const AllocationStats endAllocations = AllocationTracker::GetThreadStats();
+				Profiler::Record(name, start, end, depth, endAllocations.allocations - startAllocations.allocations,
+					endAllocations.allocatedBytes - startAllocations.allocatedBytes);
+#else
+				Profiler::Record(name, start, end, depth);
+#endif
+				Profiler::PopDepth();
+			}
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator = (const ProfileScope&) = delete;
+};
+
+// Adds the hardware counters of the enclosing block to its scope's frame totals, see PROFILE_SYSTEM
+class PerfCounterScope {
+	private:
+		const char* name;
+		PerfCounterValues start;
+		bool isActive;
+
+	public:
+		PerfCounterScope(const char* name): name(name), isActive(Profiler::IsEnabled() && PerfCounters::Read(start)) {}
+
+		~PerfCounterScope() {
+			if (isActive) {
+				PerfCounterValues delta;
+				PerfCounters::Read(delta);
+				for (int type = 0; type < PERF_COUNTER_COUNT; type++) {
+					delta.values[type] -= start.values[type];
+				}
+				Profiler::RecordCounters(name, delta);
+			}
+		}
+
+		PerfCounterScope(const PerfCounterScope&) = delete;
+		PerfCounterScope& operator = (const PerfCounterScope&) = delete;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// Build with -DPROFILER_DISABLED to compile every scope out
+#ifndef PROFILER_DISABLED
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
+
+// Scope around a whole system update. Build with -DPROFILER_PERF_COUNTERS (make PERF_COUNTERS=1) on Linux to
+// also collect cycles, instructions, cache and branch misses per system per frame. The counter scope opens
+// inside the timed one so the timing bookkeeping isn't counted.
+#if !defined(PROFILER_DISABLED) && defined(PROFILER_PERF_COUNTERS)
+#define PROFILE_SYSTEM(name) PROFILE_SCOPE(name); PerfCounterScope PROFILE_CONCAT(perfCounterScope, __LINE__)(name)
+#else
+#define PROFILE_SYSTEM(name) PROFILE_SCOPE(name)
+#endif
+
+#endif
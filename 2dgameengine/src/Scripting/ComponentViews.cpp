@@ -0,0 +1,257 @@
+#include "ComponentViews.h"
+#include "../ECS/Components/TransformComponent.h"
+#include "../ECS/Components/RigidBodyComponent.h"
+#include <new>
+
+namespace {
+	const char* BATCH_VIEW_METATABLE = "engine.BatchView";
+	const char* FIELD_VIEW_METATABLE = "engine.FieldView";
+	const char* PROXY_METATABLE = "engine.ComponentProxy";
+
+	// Registry key of the list set by SetMovedEntityIds, only its address matters
+	char movedEntityIdsKey;
+
+	struct BatchView {
+		const std::vector<Entity>* entities;
+	};
+
+	// movedEntityIds is only set for transform fields, so writes to other components skip the list
+	struct FieldView {
+		const std::vector<Entity>* entities;
+		const ComponentField* field;
+		std::vector<int>* movedEntityIds;
+	};
+
+	struct ComponentProxy {
+		Entity entity;
+		ComponentProxyType type;
+		std::vector<int>* movedEntityIds;
+	};
+
+	std::vector<int>* GetMovedEntityIds(lua_State* L, ComponentProxyType type) {
+		if (type != PROXY_TRANSFORM) {
+			return nullptr;
+		}
+		lua_rawgetp(L, LUA_REGISTRYINDEX, &movedEntityIdsKey);
+		std::vector<int>* movedEntityIds = static_cast<std::vector<int>*>(lua_touserdata(L, -1));
+		lua_pop(L, 1);
+		return movedEntityIds;
+	}
+
+	template <typename TComponent>
+	char* GetComponentData(const Entity& entity) {
+		return entity.HasComponent<TComponent>() ? reinterpret_cast<char*>(&entity.GetComponent<TComponent>()) : nullptr;
+	}
+
+	const ComponentField fields[] = {
+		{"position_x", PROXY_TRANSFORM, FIELD_FLOAT, offsetof(TransformComponent, position), GetComponentData<TransformComponent>},
+		{"position_y", PROXY_TRANSFORM, FIELD_FLOAT, offsetof(TransformComponent, position) + sizeof(float), GetComponentData<TransformComponent>},
+		{"scale_x", PROXY_TRANSFORM, FIELD_FLOAT, offsetof(TransformComponent, scale), GetComponentData<TransformComponent>},
+		{"scale_y", PROXY_TRANSFORM, FIELD_FLOAT, offsetof(TransformComponent, scale) + sizeof(float), GetComponentData<TransformComponent>},
+		{"rotation", PROXY_TRANSFORM, FIELD_DOUBLE, offsetof(TransformComponent, rotation), GetComponentData<TransformComponent>},
+		{"velocity_x", PROXY_RIGID_BODY, FIELD_FLOAT, offsetof(RigidBodyComponent, velocity), GetComponentData<RigidBodyComponent>},
+		{"velocity_y", PROXY_RIGID_BODY, FIELD_FLOAT, offsetof(RigidBodyComponent, velocity) + sizeof(float), GetComponentData<RigidBodyComponent>},
+		{nullptr, PROXY_TRANSFORM, FIELD_FLOAT, 0, nullptr}
+	};
+
+	// Lua indices start at 1, nullptr outside the list
+	const Entity* GetEntity(lua_State* L, const std::vector<Entity>* entities, int argument) {
+		const lua_Integer index = luaL_checkinteger(L, argument);
+		if (index < 1 || index > static_cast<lua_Integer>(entities->size())) {
+			return nullptr;
+		}
+		return &(*entities)[index - 1];
+	}
+
+	void PushField(lua_State* L, const ComponentField* field, const char* data) {
+		if (field->type == FIELD_FLOAT) {
+			lua_pushnumber(L, *reinterpret_cast<const float*>(data + field->offset));
+		} else {
+			lua_pushnumber(L, *reinterpret_cast<const double*>(data + field->offset));
+		}
+	}
+
+	void SetField(const ComponentField* field, char* data, lua_Number value) {
+		if (field->type == FIELD_FLOAT) {
+			*reinterpret_cast<float*>(data + field->offset) = static_cast<float>(value);
+		} else {
+			*reinterpret_cast<double*>(data + field->offset) = value;
+		}
+	}
+
+	// Metamethods only ever see their own userdata type, so no checked casts below
+
+	int BatchIndex(lua_State* L) {
+		const BatchView* view = static_cast<const BatchView*>(lua_touserdata(L, 1));
+		if (lua_type(L, 2) == LUA_TNUMBER) {
+			const Entity* entity = GetEntity(L, view->entities, 2);
+			if (entity) {
+				lua_pushinteger(L, entity->GetId());
+			} else {
+				lua_pushnil(L);
+			}
+			return 1;
+		}
+
+		// Field arrays by name, kept in the user value table
+		lua_getuservalue(L, 1);
+		lua_pushvalue(L, 2);
+		lua_rawget(L, -2);
+		return 1;
+	}
+
+	int BatchLength(lua_State* L) {
+		const BatchView* view = static_cast<const BatchView*>(lua_touserdata(L, 1));
+		lua_pushinteger(L, static_cast<lua_Integer>(view->entities->size()));
+		return 1;
+	}
+
+	int FieldIndex(lua_State* L) {
+		const FieldView* view = static_cast<const FieldView*>(lua_touserdata(L, 1));
+		const Entity* entity = GetEntity(L, view->entities, 2);
+		const char* data = entity ? view->field->GetData(*entity) : nullptr;
+		if (data) {
+			PushField(L, view->field, data);
+		} else {
+			lua_pushnil(L);
+		}
+		return 1;
+	}
+
+	int FieldNewIndex(lua_State* L) {
+		const FieldView* view = static_cast<const FieldView*>(lua_touserdata(L, 1));
+		const lua_Number value = luaL_checknumber(L, 3);
+		const Entity* entity = GetEntity(L, view->entities, 2);
+		if (!entity) {
+			return luaL_error(L, "%s index %d out of range", view->field->name, static_cast<int>(lua_tointeger(L, 2)));
+		}
+
+		char* data = view->field->GetData(*entity);
+		if (!data) {
+			return luaL_error(L, "entity %d has no component with %s", entity->GetId(), view->field->name);
+		}
+		SetField(view->field, data, value);
+		if (view->movedEntityIds) {
+			view->movedEntityIds->push_back(entity->GetId());
+		}
+		return 0;
+	}
+
+	int FieldLength(lua_State* L) {
+		const FieldView* view = static_cast<const FieldView*>(lua_touserdata(L, 1));
+		lua_pushinteger(L, static_cast<lua_Integer>(view->entities->size()));
+		return 1;
+	}
+
+	// The field named by argument 2, found in the name to field table held as upvalue 1.
+	// Raises an error for names the proxy's component doesn't have
+	const ComponentField* GetProxyField(lua_State* L, const ComponentProxy* proxy) {
+		lua_pushvalue(L, 2);
+		lua_rawget(L, lua_upvalueindex(1));
+		const ComponentField* field = static_cast<const ComponentField*>(lua_touserdata(L, -1));
+		lua_pop(L, 1);
+		if (!field || field->component != proxy->type) {
+			luaL_error(L, "component has no field %s", lua_tostring(L, 2));
+		}
+		return field;
+	}
+
+	char* GetProxyData(lua_State* L, const ComponentProxy* proxy, const ComponentField* field) {
+		char* data = field->GetData(proxy->entity);
+		if (!data) {
+			luaL_error(L, "entity %d no longer has the component with %s", proxy->entity.GetId(), field->name);
+		}
+		return data;
+	}
+
+	int ProxyIndex(lua_State* L) {
+		const ComponentProxy* proxy = static_cast<const ComponentProxy*>(lua_touserdata(L, 1));
+		const ComponentField* field = GetProxyField(L, proxy);
+		PushField(L, field, GetProxyData(L, proxy, field));
+		return 1;
+	}
+
+	int ProxyNewIndex(lua_State* L) {
+		const ComponentProxy* proxy = static_cast<const ComponentProxy*>(lua_touserdata(L, 1));
+		const ComponentField* field = GetProxyField(L, proxy);
+		SetField(field, GetProxyData(L, proxy, field), luaL_checknumber(L, 3));
+		if (proxy->movedEntityIds) {
+			proxy->movedEntityIds->push_back(proxy->entity.GetId());
+		}
+		return 0;
+	}
+}
+
+void ComponentViews::Register(lua_State* L) {
+	luaL_newmetatable(L, BATCH_VIEW_METATABLE);
+	lua_pushcfunction(L, BatchIndex);
+	lua_setfield(L, -2, "__index");
+	lua_pushcfunction(L, BatchLength);
+	lua_setfield(L, -2, "__len");
+	lua_pop(L, 1);
+
+	luaL_newmetatable(L, FIELD_VIEW_METATABLE);
+	lua_pushcfunction(L, FieldIndex);
+	lua_setfield(L, -2, "__index");
+	lua_pushcfunction(L, FieldNewIndex);
+	lua_setfield(L, -2, "__newindex");
+	lua_pushcfunction(L, FieldLength);
+	lua_setfield(L, -2, "__len");
+	lua_pop(L, 1);
+
+	// Field name to field, shared by both proxy metamethods
+	luaL_newmetatable(L, PROXY_METATABLE);
+	lua_newtable(L);
+	for (const ComponentField* field = fields; field->name; field++) {
+		lua_pushlightuserdata(L, const_cast<ComponentField*>(field));
+		lua_setfield(L, -2, field->name);
+	}
+	lua_pushvalue(L, -1);
+	lua_pushcclosure(L, ProxyIndex, 1);
+	lua_setfield(L, -3, "__index");
+	lua_pushcclosure(L, ProxyNewIndex, 1);
+	lua_setfield(L, -2, "__newindex");
+	lua_pop(L, 1);
+}
+
+void ComponentViews::SetMovedEntityIds(lua_State* L, std::vector<int>* movedEntityIds) {
+	lua_pushlightuserdata(L, movedEntityIds);
+	lua_rawsetp(L, LUA_REGISTRYINDEX, &movedEntityIdsKey);
+}
+
+sol::object ComponentViews::CreateBatchView(lua_State* L, const std::vector<Entity>* entities) {
+	BatchView* batchView = static_cast<BatchView*>(lua_newuserdata(L, sizeof(BatchView)));
+	batchView->entities = entities;
+	luaL_setmetatable(L, BATCH_VIEW_METATABLE);
+
+	std::vector<int>* movedEntityIds = GetMovedEntityIds(L, PROXY_TRANSFORM);
+	lua_newtable(L);
+	for (const ComponentField* field = fields; field->name; field++) {
+		FieldView* fieldView = static_cast<FieldView*>(lua_newuserdata(L, sizeof(FieldView)));
+		fieldView->entities = entities;
+		fieldView->field = field;
+		fieldView->movedEntityIds = field->component == PROXY_TRANSFORM ? movedEntityIds : nullptr;
+		luaL_setmetatable(L, FIELD_VIEW_METATABLE);
+		lua_setfield(L, -2, field->name);
+	}
+	lua_setuservalue(L, -2);
+
+	sol::object view(L, -1);
+	lua_pop(L, 1);
+	return view;
+}
+
+sol::object ComponentViews::CreateProxy(lua_State* L, const Entity& entity, ComponentProxyType type) {
+	// Entity is trivially destructible, so the userdata needs no __gc
+	std::vector<int>* movedEntityIds = GetMovedEntityIds(L, type);
+	new (lua_newuserdata(L, sizeof(ComponentProxy))) ComponentProxy{entity, type, movedEntityIds};
+	luaL_setmetatable(L, PROXY_METATABLE);
+
+	sol::object object(L, -1);
+	lua_pop(L, 1);
+	return object;
+}
+
+const ComponentField* ComponentViews::GetFields() {
+	return fields;
+}
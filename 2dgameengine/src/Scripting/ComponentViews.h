@@ -0,0 +1,72 @@
+#ifndef COMPONENTVIEWS_H
+#define COMPONENTVIEWS_H
+
+#include "../ECS/ECS.h"
+#include <sol/sol.hpp>
+#include <cstddef>
+#include <vector>
+
+// Components that scripts can reach through proxies, e.g. entity.transform.position_x
+enum ComponentProxyType {
+	PROXY_TRANSFORM,
+	PROXY_RIGID_BODY,
+	PROXY_TYPE_COUNT
+};
+
+enum ComponentFieldType {
+	FIELD_FLOAT,
+	FIELD_DOUBLE
+};
+
+// One number inside a component, addressed by its byte offset. GetData returns nullptr when the entity
+// doesn't have the component
+struct ComponentField {
+	const char* name;
+	ComponentProxyType component;
+	ComponentFieldType type;
+	size_t offset;
+	char* (*GetData)(const Entity& entity);
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ComponentViews: Userdata that let Lua read and write component fields in place, with no tables built or
+// values copied per access.
+//
+// A batch view wraps the entity list of one batched script. In Lua, #entities is the count, entities[i] is the
+// id of the i-th entity, and entities.position_x etc. are field arrays, so entities.position_x[i] reads the
+// position of that same entity straight from its component pool. Lookups of the field arrays by name are
+// meant to be hoisted out of the loop:
+//
+//   update_all = function(entities, deltaTime)
+//       local x, vx = entities.position_x, entities.velocity_x
+//       for i = 1, #entities do
+//           x[i] = x[i] + vx[i] * deltaTime
+//       end
+//   end
+//
+// A proxy stands for one component of one entity, e.g. entity.transform in a per-entity script. Field names
+// resolve to their offsets with one raw lookup in a shared table. Proxies keep the entity, not a pointer, and
+// find the component in its pool on every access, because pools move their storage when they grow.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class ComponentViews {
+	public:
+		// Registers the metatables, once per Lua state
+		static void Register(lua_State* L);
+
+		// Views and proxies created after this append the entity id to the list whenever a script writes a
+		// transform field, e.g. CameraSystem::GetMovedEntityIds. The list is only used by the state's thread
+		static void SetMovedEntityIds(lua_State* L, std::vector<int>* movedEntityIds);
+
+		// The view reads the vector on every access, so it follows whatever the vector holds at call time.
+		// The vector must outlive the view
+		static sol::object CreateBatchView(lua_State* L, const std::vector<Entity>* entities);
+
+		// Each call makes a new userdata, callers cache it (see ScriptComponent::proxies)
+		static sol::object CreateProxy(lua_State* L, const Entity& entity, ComponentProxyType type);
+
+		// Fields exposed to Lua, ends with a null name
+		static const ComponentField* GetFields();
+};
+
+#endif
@@ -0,0 +1,186 @@
+#include "ScriptAllocator.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/AllocationTracker.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+const size_t ScriptAllocator::classSizes[SCRIPT_ALLOCATOR_NUM_CLASSES] = {
+	16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256
+};
+
+ScriptAllocator::ScriptAllocator() {
+	for (int i = 0; i < SCRIPT_ALLOCATOR_NUM_CLASSES; i++) {
+		freeLists[i] = nullptr;
+	}
+
+	// Smallest class that fits, looked up by size rounded up to 16 bytes
+	int sizeClass = 0;
+	for (size_t i = 0; i <= SCRIPT_ALLOCATOR_MAX_SMALL_SIZE / 16; i++) {
+		while (classSizes[sizeClass] < i * 16) {
+			sizeClass++;
+		}
+		classForSize[i] = static_cast<unsigned char>(sizeClass);
+	}
+
+	chunkOffset = SCRIPT_ALLOCATOR_CHUNK_SIZE;
+	capBytes = 0;
+	hasLoggedCap = false;
+}
+
+ScriptAllocator::~ScriptAllocator() {
+	for (char* chunk: chunks) {
+		free(chunk);
+	}
+}
+
+void ScriptAllocator::SetCapBytes(size_t capBytes) {
+	this->capBytes = capBytes;
+	hasLoggedCap = false;
+}
+
+const ScriptMemoryStats& ScriptAllocator::GetStats() const {
+	return stats;
+}
+
+size_t ScriptAllocator::GetBlockSize(size_t size) const {
+	if (size > SCRIPT_ALLOCATOR_MAX_SMALL_SIZE) {
+		return size;
+	}
+	return classSizes[classForSize[(size + 15) / 16]];
+}
+
+void* ScriptAllocator::AllocateBlock(size_t size) {
+	if (size > SCRIPT_ALLOCATOR_MAX_SMALL_SIZE) {
+		void* block = malloc(size);
+		if (block) {
+			stats.largeBytes += size;
+		}
+		return block;
+	}
+
+	const int sizeClass = classForSize[(size + 15) / 16];
+	if (FreeBlock* block = freeLists[sizeClass]) {
+		freeLists[sizeClass] = block->next;
+		return block;
+	}
+
+	// Bump allocate from the newest chunk, the tail of a full one is left unused
+	const size_t blockSize = classSizes[sizeClass];
+	if (chunkOffset + blockSize > SCRIPT_ALLOCATOR_CHUNK_SIZE) {
+		char* chunk = static_cast<char*>(malloc(SCRIPT_ALLOCATOR_CHUNK_SIZE));
+		if (!chunk) {
+			return nullptr;
+		}
+		chunks.push_back(chunk);
+		chunkOffset = 0;
+		stats.chunkBytes += SCRIPT_ALLOCATOR_CHUNK_SIZE;
+	}
+	void* block = chunks.back() + chunkOffset;
+	chunkOffset += blockSize;
+	return block;
+}
+
+void ScriptAllocator::FreeBlockOfSize(void* block, size_t size) {
+	if (size > SCRIPT_ALLOCATOR_MAX_SMALL_SIZE) {
+		stats.largeBytes -= size;
+		free(block);
+		return;
+	}
+
+	const int sizeClass = classForSize[(size + 15) / 16];
+	FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+	freeBlock->next = freeLists[sizeClass];
+	freeLists[sizeClass] = freeBlock;
+}
+
+void* ScriptAllocator::Reallocate(void* block, size_t oldSize, size_t newSize) {
+	const size_t oldBlockSize = GetBlockSize(oldSize);
+	const size_t newBlockSize = GetBlockSize(newSize);
+	if (oldBlockSize == newBlockSize && newSize <= SCRIPT_ALLOCATOR_MAX_SMALL_SIZE) {
+		return block;
+	}
+
+	// Both large, realloc may grow or shrink in place
+	if (oldSize > SCRIPT_ALLOCATOR_MAX_SMALL_SIZE && newSize > SCRIPT_ALLOCATOR_MAX_SMALL_SIZE) {
+		void* newBlock = realloc(block, newSize);
+		if (newBlock) {
+			stats.largeBytes += newSize;
+			stats.largeBytes -= oldSize;
+		}
+		return newBlock;
+	}
+
+	void* newBlock = AllocateBlock(newSize);
+	if (!newBlock) {
+		if (newSize >= oldSize) {
+			return nullptr;
+		}
+
+		// Lua counts on shrinking never failing, so the old block is kept and from now on freed as a block of
+		// the smaller size. A small one just lands in a smaller class's freelist. A large one was malloc'd and
+		// would never reach free again, so it is adopted as a chunk, which the destructor frees. Inserted at
+		// the front so the last chunk stays the one being bump allocated
+		if (oldSize > SCRIPT_ALLOCATOR_MAX_SMALL_SIZE) {
+			stats.largeBytes -= oldSize;
+			stats.chunkBytes += oldSize;
+			chunks.insert(chunks.begin(), static_cast<char*>(block));
+		}
+		return block;
+	}
+	memcpy(newBlock, block, std::min(oldSize, newSize));
+	FreeBlockOfSize(block, oldSize);
+	return newBlock;
+}
+
+void* ScriptAllocator::Allocate(void* userData, void* block, size_t oldSize, size_t newSize) {
+	ScriptAllocator* allocator = static_cast<ScriptAllocator*>(userData);
+	ScriptMemoryStats& stats = allocator->stats;
+
+	if (newSize == 0) {
+		if (block) {
+			stats.bytesInUse -= allocator->GetBlockSize(oldSize);
+			stats.frees++;
+			allocator->FreeBlockOfSize(block, oldSize);
+			AllocationTracker::RecordFree();
+		}
+		return nullptr;
+	}
+
+	// Without a block Lua passes the object type in oldSize
+	if (!block) {
+		oldSize = 0;
+	}
+	const size_t oldBlockSize = block ? allocator->GetBlockSize(oldSize) : 0;
+	const size_t newBlockSize = allocator->GetBlockSize(newSize);
+
+	// Lua counts on shrinking never failing, so only growth is held to the cap
+	if (allocator->capBytes != 0 && newBlockSize > oldBlockSize &&
+		stats.bytesInUse - oldBlockSize + newBlockSize > allocator->capBytes) {
+		stats.failedAllocations++;
+		if (!allocator->hasLoggedCap) {
+			allocator->hasLoggedCap = true;
+			LOG_ERROR("Lua state reached its memory cap of %zu KB, allocation refused", allocator->capBytes / 1024);
+		}
+		return nullptr;
+	}
+
+	void* newBlock = block ? allocator->Reallocate(block, oldSize, newSize) : allocator->AllocateBlock(newSize);
+	if (!newBlock) {
+		return nullptr;
+	}
+
+	// Reported like operator new, so per-scope counts and the zero allocation assert see the Lua heap. A
+	// realloc that moves counts as a new block and a free, one that stays in place as neither
+	if (!block) {
+		stats.allocations++;
+		AllocationTracker::RecordAllocation(newBlockSize);
+	} else if (newBlock != block) {
+		AllocationTracker::RecordAllocation(newBlockSize);
+		AllocationTracker::RecordFree();
+	}
+	stats.bytesInUse += newBlockSize;
+	stats.bytesInUse -= oldBlockSize;
+	stats.peakBytesInUse = std::max(stats.peakBytesInUse, stats.bytesInUse);
+	return newBlock;
+}
@@ -0,0 +1,76 @@
+#ifndef SCRIPTALLOCATOR_H
+#define SCRIPTALLOCATOR_H
+
+#include <cstddef>
+#include <vector>
+
+// Blocks up to this size come from the size class freelists, larger ones from malloc
+const size_t SCRIPT_ALLOCATOR_MAX_SMALL_SIZE = 256;
+
+// Size classes are carved out of chunks this big
+const size_t SCRIPT_ALLOCATOR_CHUNK_SIZE = 64 * 1024;
+
+const int SCRIPT_ALLOCATOR_NUM_CLASSES = 12;
+
+struct ScriptMemoryStats {
+	size_t bytesInUse = 0;      // Size class or malloc size of every live block
+	size_t peakBytesInUse = 0;
+	size_t chunkBytes = 0;      // Reserved for the size classes, used or not
+	size_t largeBytes = 0;      // Live blocks that went to malloc
+	unsigned long long allocations = 0;
+	unsigned long long frees = 0;
+	unsigned long long failedAllocations = 0;  // Refused by the cap
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ScriptAllocator: lua_Alloc for one Lua state. Lua's many small objects (strings, table parts, closures,
+// userdata) come from size class freelists, so they avoid malloc's locks and fragment only within their
+// class. Lua passes the old size on every free and realloc, so blocks carry no header.
+//
+// With a cap set, allocations that would take the state past it fail, and Lua raises "not enough memory" in
+// the script that asked. The script's protected call catches that, so a runaway script is stopped instead of
+// taking the process down. Not thread safe, each state gets its own allocator.
+//
+// New blocks, moves and frees are reported to the AllocationTracker, so scripts that allocate every frame
+// show up in the profiler's allocation counts like the rest of the engine.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class ScriptAllocator {
+	private:
+		struct FreeBlock {
+			FreeBlock* next;
+		};
+
+		FreeBlock* freeLists[SCRIPT_ALLOCATOR_NUM_CLASSES];
+		unsigned char classForSize[SCRIPT_ALLOCATOR_MAX_SMALL_SIZE / 16 + 1];
+
+		std::vector<char*> chunks;
+		size_t chunkOffset;
+
+		size_t capBytes;
+		bool hasLoggedCap;
+		ScriptMemoryStats stats;
+
+		static const size_t classSizes[SCRIPT_ALLOCATOR_NUM_CLASSES];
+
+		size_t GetBlockSize(size_t size) const;
+		void* AllocateBlock(size_t size);
+		void FreeBlockOfSize(void* block, size_t size);
+		void* Reallocate(void* block, size_t oldSize, size_t newSize);
+
+	public:
+		ScriptAllocator();
+		~ScriptAllocator();
+		ScriptAllocator(const ScriptAllocator&) = delete;
+		ScriptAllocator& operator = (const ScriptAllocator&) = delete;
+
+		// Zero means no cap
+		void SetCapBytes(size_t capBytes);
+
+		const ScriptMemoryStats& GetStats() const;
+
+		// The lua_Alloc, pass the allocator as its user data
+		static void* Allocate(void* userData, void* block, size_t oldSize, size_t newSize);
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include "ScriptCache.h"
+#include "../Logger/Logger.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+	int WriteBytecode(lua_State*, const void* data, size_t size, void* userData) {
+		static_cast<std::string*>(userData)->append(static_cast<const char*>(data), size);
+		return 0;
+	}
+
+	// Like mkdir -p
+	bool CreateDirectories(const std::string& directory) {
+		for (size_t i = 1; i <= directory.size(); i++) {
+			if (i == directory.size() || directory[i] == '/') {
+				const std::string parent = directory.substr(0, i);
+				if (mkdir(parent.c_str(), 0755) != 0 && errno != EEXIST) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+ScriptCache::ScriptCache(const std::string& directory): directory(directory) {
+}
+
+void ScriptCache::SetDirectory(const std::string& directory) {
+	this->directory = directory;
+}
+
+const ScriptCacheStats& ScriptCache::GetStats() const {
+	return stats;
+}
+
+uint64_t ScriptCache::Hash(const std::string& filePath, const std::string& source) {
+	// FNV-1a over the path, the contents and the number formats, which the bytecode depends on
+	uint64_t hash = 14695981039346656037ull;
+	auto mix = [&hash](const void* data, size_t size) {
+		for (size_t i = 0; i < size; i++) {
+			hash ^= static_cast<const unsigned char*>(data)[i];
+			hash *= 1099511628211ull;
+		}
+	};
+	const int formats[] = {LUA_VERSION_NUM, static_cast<int>(sizeof(lua_Number)), static_cast<int>(sizeof(lua_Integer))};
+	mix(formats, sizeof(formats));
+	mix(filePath.data(), filePath.size() + 1);
+	mix(source.data(), source.size());
+	return hash;
+}
+
+bool ScriptCache::ReadFile(const std::string& filePath, std::string& contents) {
+	FILE* file = fopen(filePath.c_str(), "rb");
+	if (!file) {
+		return false;
+	}
+
+	contents.clear();
+	char buffer[16 * 1024];
+	size_t count;
+	while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+		contents.append(buffer, count);
+	}
+	const bool isRead = !ferror(file);
+	fclose(file);
+	return isRead;
+}
+
+bool ScriptCache::WriteEntry(const std::string& entryPath, const std::string& bytecode) {
+	if (!CreateDirectories(directory)) {
+		return false;
+	}
+
+	// Written aside and renamed, so a crash never leaves half an entry behind. The name is unique, so
+	// instances or worker states writing the same entry at once never share a temporary file
+	std::string temporaryPath = entryPath + ".XXXXXX";
+	const int descriptor = mkstemp(&temporaryPath[0]);
+	if (descriptor < 0) {
+		return false;
+	}
+	FILE* file = fdopen(descriptor, "wb");
+	if (!file) {
+		close(descriptor);
+		remove(temporaryPath.c_str());
+		return false;
+	}
+	const bool isWritten = fwrite(bytecode.data(), 1, bytecode.size(), file) == bytecode.size();
+	if (fclose(file) != 0 || !isWritten) {
+		remove(temporaryPath.c_str());
+		return false;
+	}
+	if (rename(temporaryPath.c_str(), entryPath.c_str()) != 0) {
+		remove(temporaryPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+int ScriptCache::Load(lua_State* L, const std::string& filePath) {
+	std::string source;
+	if (!ReadFile(filePath, source)) {
+		lua_pushfstring(L, "cannot open %s", filePath.c_str());
+		return LUA_ERRFILE;
+	}
+
+	// Same chunk name luaL_loadfile would give, so messages read the same either way
+	const std::string chunkName = "@" + filePath;
+	if (directory.empty()) {
+		return luaL_loadbufferx(L, source.data(), source.size(), chunkName.c_str(), "t");
+	}
+
+	char entryName[32];
+	snprintf(entryName, sizeof(entryName), "/%016llx.luac", static_cast<unsigned long long>(Hash(filePath, source)));
+	const std::string entryPath = directory + entryName;
+
+	std::string bytecode;
+	if (ReadFile(entryPath, bytecode)) {
+		if (luaL_loadbufferx(L, bytecode.data(), bytecode.size(), chunkName.c_str(), "b") == LUA_OK) {
+			stats.hits++;
+			return LUA_OK;
+		}
+		LOG_WARN("Discarding unreadable script cache entry %s: %s", entryPath.c_str(), lua_tostring(L, -1));
+		lua_pop(L, 1);
+	}
+
+	stats.misses++;
+	const int status = luaL_loadbufferx(L, source.data(), source.size(), chunkName.c_str(), "t");
+	if (status != LUA_OK) {
+		return status;
+	}
+
+	bytecode.clear();
+	lua_dump(L, WriteBytecode, &bytecode, 0);
+	if (!WriteEntry(entryPath, bytecode)) {
+		stats.writeFailures++;
+		LOG_WARN("Could not write script cache entry %s", entryPath.c_str());
+	}
+	return LUA_OK;
+}
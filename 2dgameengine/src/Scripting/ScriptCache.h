@@ -0,0 +1,46 @@
+#ifndef SCRIPTCACHE_H
+#define SCRIPTCACHE_H
+
+#include <sol/sol.hpp>
+#include <cstdint>
+#include <string>
+
+// Where compiled scripts go unless set otherwise, relative to the working directory like the assets
+const char* const SCRIPT_CACHE_DIRECTORY = "./cache/scripts";
+
+struct ScriptCacheStats {
+	unsigned long long hits = 0;
+	unsigned long long misses = 0;
+	unsigned long long writeFailures = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ScriptCache: Loads Lua files through a cache of their compiled bytecode, so only new or edited files are
+// parsed. Entries are named after a hash of the file's path and contents, checked against nothing else: an
+// edited file simply gets a new entry. Bytecode from another Lua build fails Lua's header check and is
+// compiled again. Debug info is kept, so errors and profiles still point at source lines.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class ScriptCache {
+	private:
+		std::string directory;
+		ScriptCacheStats stats;
+
+		static uint64_t Hash(const std::string& filePath, const std::string& source);
+		static bool ReadFile(const std::string& filePath, std::string& contents);
+		bool WriteEntry(const std::string& entryPath, const std::string& bytecode);
+
+	public:
+		ScriptCache(const std::string& directory = SCRIPT_CACHE_DIRECTORY);
+
+		// Empty turns the cache off, every load then compiles the source
+		void SetDirectory(const std::string& directory);
+
+		// Same contract as luaL_loadfile: returns LUA_OK with the chunk on the stack, or an error code with the
+		// message on the stack
+		int Load(lua_State* L, const std::string& filePath);
+
+		const ScriptCacheStats& GetStats() const;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#include "ScriptGarbageCollector.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+
+ScriptGarbageCollector::ScriptGarbageCollector(int budgetMicros, int stepKilobytes) {
+	L = nullptr;
+	budgetNanos = static_cast<int64_t>(budgetMicros) * 1000;
+	this->stepKilobytes = stepKilobytes;
+	isCollecting = false;
+}
+
+void ScriptGarbageCollector::Attach(lua_State* L) {
+	this->L = L;
+	lua_gc(L, LUA_GCSTOP, 0);
+	stats.kilobytesInUse = lua_gc(L, LUA_GCCOUNT, 0);
+	LOG_DEBUG("Lua GC runs once a frame with a budget of %lld us", static_cast<long long>(budgetNanos / 1000));
+}
+
+void ScriptGarbageCollector::SetBudgetMicros(int budgetMicros) {
+	budgetNanos = static_cast<int64_t>(budgetMicros) * 1000;
+}
+
+void ScriptGarbageCollector::Step() {
+	if (!L) {
+		return;
+	}
+
+	stats.lastStepNanos = 0;
+	stats.lastSteps = 0;
+	stats.kilobytesInUse = lua_gc(L, LUA_GCCOUNT, 0);
+
+	const int threshold = stats.kilobytesAfterLastCycle * SCRIPT_GC_PAUSE_PERCENT / 100;
+	if (!isCollecting && stats.kilobytesInUse < threshold) {
+		return;
+	}
+
+	PROFILE_SCOPE("Lua GC");
+	const int64_t start = Profiler::Now();
+
+	int64_t budget = budgetNanos;
+	if (stats.kilobytesInUse > stats.kilobytesAfterLastCycle * SCRIPT_GC_BEHIND_PERCENT / 100 && stats.cycles > 0) {
+		budget *= SCRIPT_GC_BEHIND_BUDGET_FACTOR;
+		stats.behindFrames++;
+	}
+
+	// LUA_GCSTEP runs even while automatic collection is stopped and returns 1 when it finished a cycle
+	isCollecting = true;
+	int64_t now = start;
+	do {
+		stats.lastSteps++;
+		if (lua_gc(L, LUA_GCSTEP, stepKilobytes)) {
+			isCollecting = false;
+			stats.cycles++;
+			stats.kilobytesAfterLastCycle = lua_gc(L, LUA_GCCOUNT, 0);
+			stats.kilobytesInUse = stats.kilobytesAfterLastCycle;
+		}
+		now = Profiler::Now();
+	} while (isCollecting && now - start < budget);
+
+	stats.lastStepNanos = now - start;
+}
+
+const ScriptGcStats& ScriptGarbageCollector::GetStats() const {
+	return stats;
+}
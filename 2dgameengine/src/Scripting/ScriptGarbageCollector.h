@@ -0,0 +1,53 @@
+#ifndef SCRIPTGARBAGECOLLECTOR_H
+#define SCRIPTGARBAGECOLLECTOR_H
+
+#include <sol/sol.hpp>
+#include <cstdint>
+
+// A new cycle starts once the heap has grown to this percentage of what the last cycle left, like Lua's pause
+const int SCRIPT_GC_PAUSE_PERCENT = 200;
+
+// Past this percentage collection falls behind allocation, steps may then overrun the budget
+const int SCRIPT_GC_BEHIND_PERCENT = 400;
+
+// How far steps may overrun the budget while collection is behind
+const int SCRIPT_GC_BEHIND_BUDGET_FACTOR = 4;
+
+struct ScriptGcStats {
+	int64_t lastStepNanos = 0;
+	int lastSteps = 0;
+	int kilobytesInUse = 0;
+	int kilobytesAfterLastCycle = 0;
+	unsigned long long cycles = 0;
+	unsigned long long behindFrames = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ScriptGarbageCollector: Takes Lua's incremental collector off the allocation path and runs it once a frame,
+// in the slice after rendering, for at most the given budget. Lua would otherwise collect whenever allocation
+// debt says so, in the middle of script updates. Time spent shows up as the "Lua GC" profiler scope.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class ScriptGarbageCollector {
+	private:
+		lua_State* L;
+		int64_t budgetNanos;
+		int stepKilobytes;
+		bool isCollecting;
+		ScriptGcStats stats;
+
+	public:
+		ScriptGarbageCollector(int budgetMicros = 1000, int stepKilobytes = 16);
+
+		// Stops automatic collection, from then on the state is only collected by Step
+		void Attach(lua_State* L);
+
+		void SetBudgetMicros(int budgetMicros);
+
+		// Incremental steps until the budget is spent or the cycle completes
+		void Step();
+
+		const ScriptGcStats& GetStats() const;
+};
+
+#endif
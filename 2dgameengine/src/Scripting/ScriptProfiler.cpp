@@ -0,0 +1,276 @@
+#include "ScriptProfiler.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+namespace {
+	// Registry key of the profiler attached to a state, only its address matters
+	char profilerKey;
+
+	// Depth of the "Lua" totals in the frame profiler, under the system that ran the script
+	const uint32_t FRAME_TOTAL_DEPTH = 1;
+
+	typedef std::pair<std::string, ScriptProfileEntry> NamedEntry;
+}
+
+ScriptProfiler::ScriptProfiler() {
+	L = nullptr;
+	isLineMode = false;
+	lastSampleTime = 0;
+	lastSampleInterval = 0;
+	lastLineTime = 0;
+	lastLineInterval = 0;
+}
+
+ScriptProfiler::~ScriptProfiler() {
+	Detach();
+}
+
+void ScriptProfiler::Attach(lua_State* L, int instructionsPerSample, bool isLineMode) {
+	Detach();
+	this->L = L;
+	this->isLineMode = isLineMode;
+
+	lua_pushlightuserdata(L, this);
+	lua_rawsetp(L, LUA_REGISTRYINDEX, &profilerKey);
+	lua_sethook(L, Hook, LUA_MASKCOUNT | (isLineMode ? LUA_MASKLINE : 0), std::max(instructionsPerSample, 1));
+}
+
+void ScriptProfiler::Detach() {
+	if (!L) {
+		return;
+	}
+
+	// Coroutines keep the hook they were created with, they find no profiler from now on
+	lua_sethook(L, nullptr, 0, 0);
+	lua_pushnil(L);
+	lua_rawsetp(L, LUA_REGISTRYINDEX, &profilerKey);
+	L = nullptr;
+}
+
+bool ScriptProfiler::IsAttached() const {
+	return L != nullptr;
+}
+
+void ScriptProfiler::Hook(lua_State* L, lua_Debug* debug) {
+	lua_rawgetp(L, LUA_REGISTRYINDEX, &profilerKey);
+	ScriptProfiler* profiler = static_cast<ScriptProfiler*>(lua_touserdata(L, -1));
+	lua_pop(L, 1);
+	if (!profiler) {
+		return;
+	}
+
+	if (debug->event == LUA_HOOKCOUNT) {
+		profiler->Sample(L);
+	} else if (debug->event == LUA_HOOKLINE) {
+		profiler->TimeLine(L, debug);
+	}
+}
+
+int64_t ScriptProfiler::GetInterval(int64_t now, int64_t& lastTime, int64_t& lastInterval) {
+	int64_t interval = 0;
+	if (lastTime > 0) {
+		interval = now - lastTime;
+		if (interval > SCRIPT_PROFILER_MAX_INTERVAL_NANOS) {
+			interval = lastInterval;
+		} else {
+			lastInterval = interval;
+		}
+	}
+	lastTime = now;
+	return interval;
+}
+
+void ScriptProfiler::GetFrameName(lua_Debug& debug, std::string& name) {
+	if (strcmp(debug.what, "main") == 0) {
+		name.assign("<main> (");
+		name.append(debug.short_src);
+		name.append(")");
+	} else if (strcmp(debug.what, "C") == 0) {
+		name.assign(debug.name ? debug.name : "?");
+		name.append(" [C]");
+	} else {
+		name.assign(debug.name ? debug.name : "?");
+		name.append(" (");
+		name.append(debug.short_src);
+		name.append(":");
+		name.append(std::to_string(debug.linedefined));
+		name.append(")");
+	}
+
+	// Folded stacks separate frames with semicolons
+	std::replace(name.begin(), name.end(), ';', ':');
+}
+
+void ScriptProfiler::GetLineName(const lua_Debug& debug, std::string& name) {
+	name.assign(debug.short_src);
+	name.append(":");
+	name.append(std::to_string(debug.currentline));
+}
+
+void ScriptProfiler::Sample(lua_State* thread) {
+	const int64_t interval = GetInterval(Profiler::Now(), lastSampleTime, lastSampleInterval);
+
+	lua_Debug debug;
+	if (!lua_getstack(thread, 0, &debug)) {
+		return;
+	}
+
+	// lua_getstack walks the call chain up to the level, so the depth is found by doubling and bisecting
+	// rather than level by level, which would cost the square of a deep recursion
+	int numLevels = 1;
+	while (lua_getstack(thread, numLevels * 2 - 1, &debug)) {
+		numLevels *= 2;
+	}
+	int lastMissing = numLevels * 2 - 1;
+	while (lastMissing - numLevels > 0) {
+		const int level = numLevels + (lastMissing - numLevels) / 2;
+		if (lua_getstack(thread, level, &debug)) {
+			numLevels = level + 1;
+		} else {
+			lastMissing = level;
+		}
+	}
+
+	// Innermost frame first. Deeper stacks keep both ends, the functions being run and the root they were
+	// called from, with a "..." frame standing in for the levels between
+	const bool isElided = numLevels > SCRIPT_PROFILER_MAX_DEPTH;
+	const int numInner = isElided ? SCRIPT_PROFILER_MAX_DEPTH / 2 : numLevels;
+	const int numOuter = isElided ? SCRIPT_PROFILER_MAX_DEPTH - numInner - 1 : 0;
+	const int depth = isElided ? SCRIPT_PROFILER_MAX_DEPTH : numLevels;
+	if (static_cast<int>(frames.size()) < depth) {
+		frames.resize(depth);
+	}
+
+	line.clear();
+	int frame = 0;
+	for (int level = 0; level < numLevels; level++) {
+		if (isElided && level == numInner) {
+			frames[frame++].assign("...");
+			level = numLevels - numOuter;
+		}
+		lua_getstack(thread, level, &debug);
+		lua_getinfo(thread, "Sln", &debug);
+		GetFrameName(debug, frames[frame++]);
+		if (line.empty() && debug.currentline > 0) {
+			GetLineName(debug, line);
+		}
+	}
+
+	folded.clear();
+	for (int i = depth - 1; i >= 0; i--) {
+		folded.append(frames[i]);
+		if (i > 0) {
+			folded.append(";");
+		}
+	}
+
+	ScriptProfileEntry& stack = stacks[folded];
+	stack.nanos += interval;
+	stack.samples++;
+
+	ScriptProfileEntry& function = functions[frames[0]];
+	function.nanos += interval;
+	function.samples++;
+
+	// Line mode times lines exactly, samples would count them twice
+	if (!isLineMode && !line.empty()) {
+		ScriptProfileEntry& lineEntry = lines[line];
+		lineEntry.nanos += interval;
+		lineEntry.samples++;
+	}
+
+	frameName.assign("Lua ");
+	frameName.append(frames[0]);
+	auto name = frameNames.find(frameName);
+	if (name == frameNames.end()) {
+		name = frameNames.insert(frameName).first;
+	}
+	ScriptProfileEntry& frameFunction = frameFunctions[name->c_str()];
+	frameFunction.nanos += interval;
+	frameFunction.samples++;
+}
+
+void ScriptProfiler::TimeLine(lua_State* thread, lua_Debug* debug) {
+	// The time since the previous line event was spent on the previous line
+	const int64_t interval = GetInterval(Profiler::Now(), lastLineTime, lastLineInterval);
+	if (!lastLine.empty()) {
+		ScriptProfileEntry& lineEntry = lines[lastLine];
+		lineEntry.nanos += interval;
+		lineEntry.samples++;
+	}
+
+	lua_getinfo(thread, "S", debug);
+	GetLineName(*debug, lastLine);
+}
+
+void ScriptProfiler::PublishFrame() {
+	const bool isEnabled = Profiler::IsEnabled();
+	const int64_t now = Profiler::Now();
+
+	// Entries are zeroed rather than erased so functions seen before cost no allocation next frame
+	for (auto& frameFunction: frameFunctions) {
+		ScriptProfileEntry& entry = frameFunction.second;
+		if (entry.samples == 0) {
+			continue;
+		}
+		if (isEnabled) {
+			Profiler::RecordTotal(frameFunction.first, now, entry.nanos, static_cast<uint32_t>(entry.samples), FRAME_TOTAL_DEPTH);
+		}
+		entry = ScriptProfileEntry();
+	}
+}
+
+const std::unordered_map<std::string, ScriptProfileEntry>& ScriptProfiler::GetFunctions() const {
+	return functions;
+}
+
+const std::unordered_map<std::string, ScriptProfileEntry>& ScriptProfiler::GetLines() const {
+	return lines;
+}
+
+bool ScriptProfiler::WriteFoldedStacks(const std::string& filePath) const {
+	FILE* file = fopen(filePath.c_str(), "w");
+	if (!file) {
+		LOG_ERROR("Error opening Lua profile %s", filePath.c_str());
+		return false;
+	}
+
+	// Sorted so the same run writes the same file, flamegraph tools don't care about the order
+	std::vector<NamedEntry> sorted(stacks.begin(), stacks.end());
+	std::sort(sorted.begin(), sorted.end(), [](const NamedEntry& a, const NamedEntry& b) {
+		return a.first < b.first;
+	});
+	for (const auto& stack: sorted) {
+		// Whole microseconds, at least one so every sampled stack appears
+		const long long micros = std::max<long long>(stack.second.nanos / 1000, 1);
+		fprintf(file, "%s %lld\n", stack.first.c_str(), micros);
+	}
+
+	const bool isWritten = fclose(file) == 0;
+	LOG_INFO("Lua profile written to %s, %zu stacks", filePath.c_str(), sorted.size());
+	return isWritten;
+}
+
+bool ScriptProfiler::WriteLineTimes(const std::string& filePath) const {
+	FILE* file = fopen(filePath.c_str(), "w");
+	if (!file) {
+		LOG_ERROR("Error opening Lua line profile %s", filePath.c_str());
+		return false;
+	}
+
+	std::vector<NamedEntry> sorted(lines.begin(), lines.end());
+	std::sort(sorted.begin(), sorted.end(), [](const NamedEntry& a, const NamedEntry& b) {
+		return a.second.nanos != b.second.nanos ? a.second.nanos > b.second.nanos : a.first < b.first;
+	});
+	for (const auto& entry: sorted) {
+		fprintf(file, "%s %.1f %llu\n", entry.first.c_str(), entry.second.nanos / 1000.0, entry.second.samples);
+	}
+
+	const bool isWritten = fclose(file) == 0;
+	LOG_INFO("Lua line profile written to %s, %zu lines", filePath.c_str(), sorted.size());
+	return isWritten;
+}
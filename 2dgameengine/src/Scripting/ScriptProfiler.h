@@ -0,0 +1,101 @@
+#ifndef SCRIPTPROFILER_H
+#define SCRIPTPROFILER_H
+
+#include <sol/sol.hpp>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// VM instructions between two samples of the Lua stack
+const int SCRIPT_PROFILER_INSTRUCTIONS_PER_SAMPLE = 1000;
+
+// Intervals between hook events longer than this span time outside Lua, e.g. the rest of the frame,
+// and are counted as the previous interval instead
+const int64_t SCRIPT_PROFILER_MAX_INTERVAL_NANOS = 250000;
+
+// Frames kept per sample. Deeper stacks keep the innermost and outermost halves, the levels between them
+// become a single "..." frame
+const int SCRIPT_PROFILER_MAX_DEPTH = 64;
+
+struct ScriptProfileEntry {
+	int64_t nanos = 0;
+	unsigned long long samples = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ScriptProfiler: Samples the Lua stack from a count hook and attributes the time between samples to the
+// sampled stack, to the function on top of it, and to the line it was running. Line mode adds a line hook
+// that times every executed line exactly, at a much higher cost.
+//
+// Per-function time since the last PublishFrame goes to the frame profiler as "Lua <function>" totals, so it
+// shows up next to the engine's own scopes. WriteFoldedStacks writes one "root;caller;function microseconds"
+// line per stack, the format flamegraph.pl and speedscope read.
+//
+// Hooks are per lua_State and run on whatever thread runs the state, so one profiler serves one state and
+// the coroutines created from it.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class ScriptProfiler {
+	private:
+		lua_State* L;
+		bool isLineMode;
+
+		int64_t lastSampleTime;
+		int64_t lastSampleInterval;
+		int64_t lastLineTime;
+		int64_t lastLineInterval;
+		std::string lastLine;
+
+		// [Key = folded stack, source:line or function name]
+		std::unordered_map<std::string, ScriptProfileEntry> stacks;
+		std::unordered_map<std::string, ScriptProfileEntry> lines;
+		std::unordered_map<std::string, ScriptProfileEntry> functions;
+
+		// Names handed to the frame profiler, which keeps the pointers, and the time each got this frame.
+		// Set nodes never move, so the pointers stay valid for the profiler's lifetime
+		std::unordered_set<std::string> frameNames;
+		std::unordered_map<const char*, ScriptProfileEntry> frameFunctions;
+
+		// Reused by every sample
+		std::vector<std::string> frames;
+		std::string folded;
+		std::string line;
+		std::string frameName;
+
+		static void Hook(lua_State* L, lua_Debug* debug);
+		static int64_t GetInterval(int64_t now, int64_t& lastTime, int64_t& lastInterval);
+		static void GetFrameName(lua_Debug& debug, std::string& name);
+		static void GetLineName(const lua_Debug& debug, std::string& name);
+
+		void Sample(lua_State* thread);
+		void TimeLine(lua_State* thread, lua_Debug* debug);
+
+	public:
+		ScriptProfiler();
+		~ScriptProfiler();
+		ScriptProfiler(const ScriptProfiler&) = delete;
+		ScriptProfiler& operator = (const ScriptProfiler&) = delete;
+
+		// Hooks the state. Coroutines inherit the hooks of the thread that creates them, so attach before any
+		// are started
+		void Attach(lua_State* L, int instructionsPerSample = SCRIPT_PROFILER_INSTRUCTIONS_PER_SAMPLE, bool isLineMode = false);
+		void Detach();
+		bool IsAttached() const;
+
+		// Records per-function time since the last call on the frame profiler, call it on the state's
+		// thread before Profiler::BeginFrame
+		void PublishFrame();
+
+		const std::unordered_map<std::string, ScriptProfileEntry>& GetFunctions() const;
+		const std::unordered_map<std::string, ScriptProfileEntry>& GetLines() const;
+
+		// Flamegraph input, values in microseconds
+		bool WriteFoldedStacks(const std::string& filePath) const;
+
+		// "source:line microseconds samples" per line, slowest first
+		bool WriteLineTimes(const std::string& filePath) const;
+};
+
+#endif
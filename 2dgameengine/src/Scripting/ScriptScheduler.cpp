@@ -0,0 +1,222 @@
+#include "ScriptScheduler.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	// Pushed as light userdata ahead of what wait and wait_until yield, only their address matters, so values
+	// from a plain coroutine.yield are never mistaken for them
+	char waitTimerMarker;
+	char waitConditionMarker;
+}
+
+ScriptScheduler::ScriptScheduler() {
+	L = nullptr;
+	tickSeconds = 1.0 / 60.0;
+	currentOwnerId = -1;
+	numStaleTimers = 0;
+	numStaleConditions = 0;
+}
+
+void ScriptScheduler::Attach(lua_State* L, double tickSeconds) {
+	this->L = L;
+	this->tickSeconds = tickSeconds;
+
+	lua_pushlightuserdata(L, this);
+	lua_pushcclosure(L, StartCoroutine, 1);
+	lua_setglobal(L, "start_coroutine");
+	lua_pushcfunction(L, Wait);
+	lua_setglobal(L, "wait");
+	lua_pushcfunction(L, WaitUntil);
+	lua_setglobal(L, "wait_until");
+}
+
+int ScriptScheduler::StartCoroutine(lua_State* L) {
+	ScriptScheduler* scheduler = static_cast<ScriptScheduler*>(lua_touserdata(L, lua_upvalueindex(1)));
+	luaL_checktype(L, 1, LUA_TFUNCTION);
+	const int numValues = lua_gettop(L);
+
+	// The registry reference keeps the thread alive while it waits
+	lua_State* thread = lua_newthread(L);
+	const int threadRef = luaL_ref(L, LUA_REGISTRYINDEX);
+	lua_xmove(L, thread, numValues);
+
+	int index;
+	if (!scheduler->freeIndices.empty()) {
+		index = scheduler->freeIndices.back();
+		scheduler->freeIndices.pop_back();
+	} else {
+		index = static_cast<int>(scheduler->coroutines.size());
+		scheduler->coroutines.push_back(Coroutine());
+	}
+	const int ownerId = scheduler->currentOwnerId;
+	scheduler->coroutines[index] = {thread, threadRef, LUA_NOREF, ownerId, scheduler->coroutines[index].sequence};
+	if (ownerId >= 0) {
+		if (ownerId >= static_cast<int>(scheduler->ownedCoroutines.size())) {
+			scheduler->ownedCoroutines.resize(ownerId + 1);
+		}
+		scheduler->ownedCoroutines[ownerId].push_back(index);
+	}
+	scheduler->stats.started++;
+
+	scheduler->Resume(index, numValues - 1, L);
+	return 0;
+}
+
+int ScriptScheduler::Wait(lua_State* L) {
+	const lua_Number seconds = luaL_optnumber(L, 1, 0.0);
+	lua_settop(L, 0);
+	lua_pushlightuserdata(L, &waitTimerMarker);
+	lua_pushnumber(L, seconds);
+	return lua_yield(L, 2);
+}
+
+int ScriptScheduler::WaitUntil(lua_State* L) {
+	luaL_checktype(L, 1, LUA_TFUNCTION);
+	lua_settop(L, 1);
+	lua_pushlightuserdata(L, &waitConditionMarker);
+	lua_insert(L, 1);
+	return lua_yield(L, 2);
+}
+
+void ScriptScheduler::Resume(int index, int numArguments, lua_State* from) {
+	// Not kept across lua_resume, the coroutine may start others and grow the vector
+	lua_State* thread = coroutines[index].thread;
+	stats.resumes++;
+
+	// Coroutines it starts belong to the same entity
+	const int previousOwnerId = currentOwnerId;
+	currentOwnerId = coroutines[index].ownerId;
+	const int status = lua_resume(thread, from, numArguments);
+	currentOwnerId = previousOwnerId;
+	if (status == LUA_OK) {
+		Finish(index);
+		return;
+	}
+	if (status != LUA_YIELD) {
+		luaL_traceback(L, thread, lua_tostring(thread, -1), 0);
+		LOG_ERROR("Coroutine error: %s", lua_tostring(L, -1));
+		lua_pop(L, 1);
+		stats.errors++;
+		Finish(index);
+		return;
+	}
+
+	const void* kind = lua_gettop(thread) == 2 ? lua_touserdata(thread, 1) : nullptr;
+	if (kind == &waitConditionMarker) {
+		lua_xmove(thread, L, 1);
+		coroutines[index].conditionRef = luaL_ref(L, LUA_REGISTRYINDEX);
+		conditionWaiters.push_back(GetWaitId(index));
+	} else {
+		// Whole ticks, at least one; a plain yield waits for the next tick. Clamped while still a double, since
+		// converting math.huge or anything past the uint64 range is undefined, and NaN ends up as one tick
+		const double seconds = kind == &waitTimerMarker ? lua_tonumber(thread, 2) : 0.0;
+		const double ticks = std::max(1.0, std::ceil(seconds / tickSeconds - 1e-9));
+		timers.Schedule(GetWaitId(index), static_cast<uint64_t>(std::min(ticks, static_cast<double>(TIMER_WHEEL_MAX_DELAY))));
+	}
+	lua_settop(thread, 0);
+}
+
+void ScriptScheduler::Finish(int index) {
+	Coroutine& coroutine = coroutines[index];
+	if (coroutine.ownerId >= 0) {
+		std::vector<int>& owned = ownedCoroutines[coroutine.ownerId];
+		auto position = std::find(owned.begin(), owned.end(), index);
+		*position = owned.back();
+		owned.pop_back();
+	}
+	luaL_unref(L, LUA_REGISTRYINDEX, coroutine.threadRef);
+	luaL_unref(L, LUA_REGISTRYINDEX, coroutine.conditionRef);
+	coroutine = {nullptr, LUA_NOREF, LUA_NOREF, -1, coroutine.sequence + 1};
+	freeIndices.push_back(index);
+}
+
+uint64_t ScriptScheduler::GetWaitId(int index) const {
+	return (static_cast<uint64_t>(coroutines[index].sequence) << 32) | static_cast<uint32_t>(index);
+}
+
+int ScriptScheduler::GetWaitingIndex(uint64_t waitId) const {
+	const int index = static_cast<int>(static_cast<uint32_t>(waitId));
+	return coroutines[index].sequence == static_cast<uint32_t>(waitId >> 32) ? index : -1;
+}
+
+void ScriptScheduler::SetCurrentOwner(int entityId) {
+	currentOwnerId = entityId;
+}
+
+void ScriptScheduler::CancelOwnedBy(int entityId) {
+	if (!L || entityId < 0 || entityId >= static_cast<int>(ownedCoroutines.size())) {
+		return;
+	}
+
+	// The timer wheel can't unschedule, so the waits stay queued. The new sequence marks them stale, and
+	// Tick drops them when they come up, whoever holds the slot by then
+	for (int index: ownedCoroutines[entityId]) {
+		Coroutine& coroutine = coroutines[index];
+		if (coroutine.conditionRef != LUA_NOREF) {
+			numStaleConditions++;
+		} else {
+			numStaleTimers++;
+		}
+		luaL_unref(L, LUA_REGISTRYINDEX, coroutine.threadRef);
+		luaL_unref(L, LUA_REGISTRYINDEX, coroutine.conditionRef);
+		coroutine = {nullptr, LUA_NOREF, LUA_NOREF, -1, coroutine.sequence + 1};
+		freeIndices.push_back(index);
+		stats.cancelled++;
+	}
+	ownedCoroutines[entityId].clear();
+}
+
+void ScriptScheduler::Tick() {
+	if (!L) {
+		return;
+	}
+	PROFILE_SCOPE("ScriptScheduler::Tick");
+
+	due.clear();
+	timers.Advance(due);
+	for (uint64_t waitId: due) {
+		const int index = GetWaitingIndex(waitId);
+		if (index < 0) {
+			numStaleTimers--;
+			continue;
+		}
+		Resume(index, 0, L);
+	}
+
+	// Waits started while polling go to the fresh list and are first checked next tick
+	pollingWaiters.swap(conditionWaiters);
+	conditionWaiters.clear();
+	for (uint64_t waitId: pollingWaiters) {
+		const int index = GetWaitingIndex(waitId);
+		if (index < 0) {
+			numStaleConditions--;
+			continue;
+		}
+		lua_rawgeti(L, LUA_REGISTRYINDEX, coroutines[index].conditionRef);
+		if (lua_pcall(L, 0, 1, 0) != LUA_OK) {
+			LOG_ERROR("Coroutine wait_until condition error: %s", lua_tostring(L, -1));
+			lua_pop(L, 1);
+			stats.errors++;
+			Finish(index);
+			continue;
+		}
+
+		const bool isMet = lua_toboolean(L, -1);
+		lua_pop(L, 1);
+		if (!isMet) {
+			conditionWaiters.push_back(waitId);
+			continue;
+		}
+		luaL_unref(L, LUA_REGISTRYINDEX, coroutines[index].conditionRef);
+		coroutines[index].conditionRef = LUA_NOREF;
+		Resume(index, 0, L);
+	}
+}
+
+const ScriptSchedulerStats& ScriptScheduler::GetStats() {
+	stats.waitingOnTimers = timers.GetSize() - numStaleTimers;
+	stats.waitingOnConditions = conditionWaiters.size() - numStaleConditions;
+	return stats;
+}
@@ -0,0 +1,106 @@
+#ifndef SCRIPTSCHEDULER_H
+#define SCRIPTSCHEDULER_H
+
+#include "../Timing/TimerWheel.h"
+#include <sol/sol.hpp>
+#include <cstdint>
+#include <vector>
+
+struct ScriptSchedulerStats {
+	size_t waitingOnTimers = 0;
+	size_t waitingOnConditions = 0;
+	unsigned long long started = 0;
+	unsigned long long resumes = 0;
+	unsigned long long errors = 0;
+	unsigned long long cancelled = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ScriptScheduler: Runs Lua coroutines that wait on game time or on a condition, one tick per simulation step.
+// Scripts get three functions:
+//
+//   start_coroutine(function, ...)  Runs the function as a coroutine right away, until its first wait
+//   wait(seconds)                   Suspends for at least that long, rounded up to whole ticks; no argument
+//                                   or a plain coroutine.yield() waits for the next tick
+//   wait_until(condition)           Suspends until condition() returns true, checked once per tick
+//
+// Timed waits sit in a TimerWheel, so only coroutines that are due get resumed, however many are suspended.
+// Conditions can't be indexed like that, those are the only waits polled every tick.
+//
+// A coroutine belongs to the entity whose script started it, directly or from another of its coroutines, and
+// CancelOwnedBy drops them when that entity is removed, so they never run against a dead one.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class ScriptScheduler {
+	private:
+		struct Coroutine {
+			lua_State* thread;
+			int threadRef;
+			int conditionRef;
+			// Entity id, -1 when started outside an entity's script
+			int ownerId;
+			// Bumped whenever the slot is freed. Waits are queued with the value they started under, so the
+			// ones a cancelled coroutine leaves in the wheel or the condition list are told apart from waits
+			// of the slot's next coroutine
+			uint32_t sequence;
+		};
+
+		lua_State* L;
+		double tickSeconds;
+		TimerWheel timers;
+
+		// [Vector index = coroutine index, the low half of a wait id]
+		std::vector<Coroutine> coroutines;
+		std::vector<int> freeIndices;
+
+		// Wait ids, see GetWaitId
+		std::vector<uint64_t> conditionWaiters;
+		std::vector<uint64_t> pollingWaiters;
+		std::vector<uint64_t> due;
+
+		// Waits of cancelled coroutines still queued, left out of the stats
+		size_t numStaleTimers;
+		size_t numStaleConditions;
+
+		// Owner of the coroutines started from now on
+		int currentOwnerId;
+
+		// [Vector index = entity id]
+		std::vector<std::vector<int>> ownedCoroutines;
+
+		ScriptSchedulerStats stats;
+
+		// from is the state doing the resume, the main one or a coroutine calling start_coroutine
+		void Resume(int index, int numArguments, lua_State* from);
+		void Finish(int index);
+
+		// Sequence in the high half, index in the low half
+		uint64_t GetWaitId(int index) const;
+
+		// Index of the coroutine still waiting under the id, -1 when it was cancelled since
+		int GetWaitingIndex(uint64_t waitId) const;
+
+		static int StartCoroutine(lua_State* L);
+		static int Wait(lua_State* L);
+		static int WaitUntil(lua_State* L);
+
+	public:
+		ScriptScheduler();
+
+		// Registers start_coroutine, wait and wait_until in the state
+		void Attach(lua_State* L, double tickSeconds);
+
+		// Resumes what is due, once per simulation step
+		void Tick();
+
+		// Set to the entity while its script runs and back to -1 after
+		void SetCurrentOwner(int entityId);
+
+		// Drops the entity's coroutines wherever they are waiting and frees their slots right away, none of
+		// them resumes again
+		void CancelOwnedBy(int entityId);
+
+		const ScriptSchedulerStats& GetStats();
+};
+
+#endif
@@ -0,0 +1,293 @@
+#include "ScriptWorkerPool.h"
+#include "ComponentViews.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+#include <algorithm>
+
+ScriptWorkerPool::Worker::Worker(int index):
+	index(index), lua(sol::default_at_panic, ScriptAllocator::Allocate, &allocator) {
+}
+
+ScriptWorkerPool::ScriptWorkerPool():
+	registry(nullptr), movedEntityIds(nullptr), gcBudgetMicros(1000), generation(0), numPending(0), isStopping(false),
+	task(TASK_UPDATE), deltaTime(0) {
+}
+
+ScriptWorkerPool::~ScriptWorkerPool() {
+	Stop();
+}
+
+void ScriptWorkerPool::Start(Registry* registry, int numWorkers, size_t memoryCapBytes, const std::string& cacheDirectory) {
+	Stop();
+	this->registry = registry;
+	scriptCache.SetDirectory(cacheDirectory);
+
+	for (int i = 0; i < numWorkers; i++) {
+		workers.emplace_back(new Worker(i));
+		Worker& worker = *workers.back();
+		worker.allocator.SetCapBytes(memoryCapBytes);
+		worker.lua.open_libraries(sol::lib::base, sol::lib::math, sol::lib::string, sol::lib::table);
+		CreateBindings(worker);
+		worker.garbageCollector.SetBudgetMicros(gcBudgetMicros);
+		worker.garbageCollector.Attach(worker.lua.lua_state());
+	}
+	for (auto& worker: workers) {
+		worker->thread = std::thread(&ScriptWorkerPool::RunWorker, this, std::ref(*worker));
+	}
+	if (numWorkers > 0) {
+		LOG_INFO("Started %d script workers", numWorkers);
+	}
+}
+
+void ScriptWorkerPool::Stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		isStopping = true;
+	}
+	startCondition.notify_all();
+	for (auto& worker: workers) {
+		if (worker->thread.joinable()) {
+			worker->thread.join();
+		}
+	}
+
+	workers.clear();
+	groupPaths.clear();
+	groupEntities.clear();
+	generation = 0;
+	isStopping = false;
+}
+
+int ScriptWorkerPool::GetNumWorkers() const {
+	return static_cast<int>(workers.size());
+}
+
+void ScriptWorkerPool::SetGcBudgetMicros(int budgetMicros) {
+	gcBudgetMicros = budgetMicros;
+	for (auto& worker: workers) {
+		worker->garbageCollector.SetBudgetMicros(budgetMicros);
+	}
+}
+
+void ScriptWorkerPool::CreateBindings(Worker& worker) {
+	ComponentViews::Register(worker.lua.lua_state());
+	ComponentViews::SetMovedEntityIds(worker.lua.lua_state(), &worker.movedEntityIds);
+
+	// Applied by Run on the main thread, ids that aren't alive by then are dropped
+	worker.lua.set_function("kill", [&worker](int entityId) {
+		worker.commands.push_back({COMMAND_KILL_ENTITY, entityId});
+	});
+	worker.lua.set_function("post_message", [&worker](const std::string& topic, int entityId, double value) {
+		worker.outbox.push_back({topic, entityId, value});
+	});
+	worker.lua["worker_index"] = worker.index;
+}
+
+int ScriptWorkerPool::AddGroup(const std::string& filePath) {
+	const int group = static_cast<int>(groupPaths.size());
+
+	// Loaded one state at a time on the calling thread, so the cache is only ever used from here
+	std::vector<sol::protected_function> updateAlls;
+	for (auto& worker: workers) {
+		lua_State* L = worker->lua.lua_state();
+		if (scriptCache.Load(L, filePath) != LUA_OK) {
+			LOG_ERROR("Error loading script %s on worker %d: %s", filePath.c_str(), worker->index, lua_tostring(L, -1));
+			lua_pop(L, 1);
+			return -1;
+		}
+
+		sol::protected_function chunk(L, -1);
+		lua_pop(L, 1);
+		sol::protected_function_result result = chunk();
+		if (!result.valid()) {
+			sol::error error = result;
+			LOG_ERROR("Error running script %s on worker %d: %s", filePath.c_str(), worker->index, error.what());
+			return -1;
+		}
+		if (result.get_type() != sol::type::table || result.get<sol::table>()["update_all"].get_type() != sol::type::function) {
+			LOG_ERROR("Parallel script %s must return a table with update_all", filePath.c_str());
+			return -1;
+		}
+		updateAlls.push_back(result.get<sol::table>()["update_all"]);
+	}
+
+	// Added only once every worker has loaded the file, so all of them agree on the group indices
+	for (size_t i = 0; i < workers.size(); i++) {
+		Worker& worker = *workers[i];
+		worker.updateAlls.push_back(updateAlls[i]);
+		worker.entities.emplace_back();
+		worker.views.push_back(ComponentViews::CreateBatchView(worker.lua.lua_state(), &worker.entities.back()));
+	}
+	groupPaths.push_back(filePath);
+	groupEntities.emplace_back();
+	return group;
+}
+
+void ScriptWorkerPool::SetMovedEntityIds(std::vector<int>* movedEntityIds) {
+	this->movedEntityIds = movedEntityIds;
+}
+
+void ScriptWorkerPool::SetGlobal(const std::string& name, double value) {
+	for (auto& worker: workers) {
+		worker->lua[name] = value;
+	}
+}
+
+void ScriptWorkerPool::ClearEntities() {
+	for (auto& entities: groupEntities) {
+		entities.clear();
+	}
+}
+
+void ScriptWorkerPool::AddEntity(int group, const Entity& entity) {
+	groupEntities[group].push_back(entity);
+}
+
+void ScriptWorkerPool::RunWorker(Worker& worker) {
+	Profiler::SetThreadName("ScriptWorker " + std::to_string(worker.index));
+
+	unsigned long long lastGeneration = 0;
+	while (true) {
+		WorkerTask currentTask;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			startCondition.wait(lock, [this, lastGeneration]() { return isStopping || generation != lastGeneration; });
+			if (isStopping) {
+				return;
+			}
+			lastGeneration = generation;
+			currentTask = task;
+		}
+
+		if (currentTask == TASK_COLLECT_GARBAGE) {
+			worker.garbageCollector.Step();
+		} else {
+			Process(worker);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			numPending--;
+			if (numPending == 0) {
+				doneCondition.notify_one();
+			}
+		}
+	}
+}
+
+void ScriptWorkerPool::Process(Worker& worker) {
+	PROFILE_SCOPE("ScriptWorker::Process");
+
+	// The inbox is only read while workers run, so every worker shares it without copies
+	if (!inbox.empty()) {
+		sol::object handler = worker.lua["on_message"];
+		if (handler.get_type() == sol::type::function) {
+			sol::protected_function onMessage = handler;
+			for (const auto& message: inbox) {
+				sol::protected_function_result result = onMessage(message.topic, message.entityId, message.value);
+				if (!result.valid()) {
+					sol::error error = result;
+					LOG_ERROR("Script error in on_message on worker %d: %s", worker.index, error.what());
+					break;
+				}
+			}
+		}
+	}
+
+	for (size_t group = 0; group < worker.entities.size(); group++) {
+		sol::protected_function& updateAll = worker.updateAlls[group];
+		if (worker.entities[group].empty() || !updateAll.valid()) {
+			continue;
+		}
+
+		sol::protected_function_result result = updateAll(worker.views[group], deltaTime);
+		if (!result.valid()) {
+			// Only this worker's copy is disabled, the others keep their share of the group running
+			sol::error error = result;
+			LOG_ERROR("Script error in %s update_all on worker %d, disabled: %s", groupPaths[group].c_str(), worker.index, error.what());
+			updateAll = sol::lua_nil;
+		}
+	}
+}
+
+void ScriptWorkerPool::RunTask(WorkerTask task) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->task = task;
+		numPending = static_cast<int>(workers.size());
+		generation++;
+	}
+	startCondition.notify_all();
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		doneCondition.wait(lock, [this]() { return numPending == 0; });
+	}
+}
+
+void ScriptWorkerPool::Run(double deltaTime) {
+	PROFILE_SCOPE("ScriptWorkerPool::Run");
+
+	if (!workers.empty()) {
+		// Contiguous ranges keep each worker on its own stretch of the entity list
+		const size_t numWorkers = workers.size();
+		for (size_t group = 0; group < groupEntities.size(); group++) {
+			const std::vector<Entity>& entities = groupEntities[group];
+			const size_t chunkSize = (entities.size() + numWorkers - 1) / numWorkers;
+			for (size_t i = 0; i < numWorkers; i++) {
+				const size_t begin = std::min(entities.size(), i * chunkSize);
+				const size_t end = std::min(entities.size(), begin + chunkSize);
+				workers[i]->entities[group].assign(entities.begin() + begin, entities.begin() + end);
+			}
+		}
+
+		// Read by the workers only after RunTask's lock hands them the new generation
+		this->deltaTime = deltaTime;
+		RunTask(TASK_UPDATE);
+	}
+
+	// Workers are idle again, so their buffers are safe to drain. Worker order keeps the result deterministic
+	inbox.clear();
+	inbox.swap(mainOutbox);
+	for (auto& worker: workers) {
+		for (const auto& command: worker->commands) {
+			if (command.type == COMMAND_KILL_ENTITY) {
+				KillEntity(command.entityId);
+			}
+		}
+		worker->commands.clear();
+
+		if (movedEntityIds) {
+			movedEntityIds->insert(movedEntityIds->end(), worker->movedEntityIds.begin(), worker->movedEntityIds.end());
+		}
+		worker->movedEntityIds.clear();
+
+		inbox.insert(inbox.end(), worker->outbox.begin(), worker->outbox.end());
+		worker->outbox.clear();
+	}
+}
+
+void ScriptWorkerPool::KillEntity(int entityId) {
+	// Ids can come from scripts that kept them past the entity's removal
+	if (!registry || !registry->IsEntityAlive(entityId)) {
+		return;
+	}
+	Entity entity(entityId);
+	entity.registry = registry;
+	registry->KillEntity(entity);
+}
+
+void ScriptWorkerPool::StepGarbageCollectors() {
+	if (workers.empty()) {
+		return;
+	}
+	PROFILE_SCOPE("ScriptWorkerPool::StepGarbageCollectors");
+	RunTask(TASK_COLLECT_GARBAGE);
+}
+
+void ScriptWorkerPool::PostMessage(const std::string& topic, int entityId, double value) {
+	mainOutbox.push_back({topic, entityId, value});
+}
+
+const std::vector<ScriptMessage>& ScriptWorkerPool::GetMessages() const {
+	return inbox;
+}
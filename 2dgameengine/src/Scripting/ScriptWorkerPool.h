@@ -0,0 +1,152 @@
+#ifndef SCRIPTWORKERPOOL_H
+#define SCRIPTWORKERPOOL_H
+
+#include "../ECS/ECS.h"
+#include "ScriptAllocator.h"
+#include "ScriptCache.h"
+#include "ScriptGarbageCollector.h"
+#include <sol/sol.hpp>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Posted with post_message(topic, entityId, value) from any Lua state, handed to every state's
+// on_message(topic, entityId, value) on the next simulation step
+struct ScriptMessage {
+	std::string topic;
+	int entityId;
+	double value;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ScriptWorkerPool: Runs parallel script groups on worker threads, each worker with its own Lua state,
+// allocator, collector and bindings. A group is a batched script that sets parallel = true:
+//
+//   return {
+//       parallel = true,
+//       update_all = function(entities, deltaTime) ... end
+//   }
+//
+// Every worker loads the file in its own state. Each step the group's entities are split into one contiguous
+// range per worker, and each worker calls its update_all on its range, so scripts in a group must not read
+// or write entities outside the view they are given.
+//
+// Nothing touches the Registry from a worker. kill(entityId) goes into the worker's command buffer, which the
+// main thread applies once every worker is done. Messages are double buffered: those posted during a step are
+// delivered on the next one, when no state writes to the queue, so neither side needs a lock.
+//
+// Worker states are collected only by StepGarbageCollectors, all at once in the slice after rendering like the
+// main state, so collection stays off the simulation's critical path.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class ScriptWorkerPool {
+	private:
+		enum WorkerTask {
+			TASK_UPDATE,
+			TASK_COLLECT_GARBAGE
+		};
+
+		enum CommandType {
+			COMMAND_KILL_ENTITY
+		};
+
+		struct Command {
+			CommandType type;
+			int entityId;
+		};
+
+		struct Worker {
+			int index;
+			ScriptAllocator allocator;  // Declared before lua, which allocates through it until destroyed
+			sol::state lua;
+			ScriptGarbageCollector garbageCollector;
+			std::thread thread;
+
+			// [Deque index = group]
+			std::deque<std::vector<Entity>> entities;
+			std::deque<sol::protected_function> updateAlls;
+			std::deque<sol::object> views;
+
+			std::vector<Command> commands;
+			std::vector<ScriptMessage> outbox;
+			std::vector<int> movedEntityIds;
+
+			Worker(int index);
+		};
+
+		Registry* registry;
+		std::vector<int>* movedEntityIds;
+		std::vector<std::unique_ptr<Worker>> workers;
+		std::vector<std::string> groupPaths;
+		ScriptCache scriptCache;
+		int gcBudgetMicros;
+
+		// [Vector index = group], filled by the ScriptSystem every step
+		std::vector<std::vector<Entity>> groupEntities;
+
+		// Delivered this step, and the main state's posts for the next one
+		std::vector<ScriptMessage> inbox;
+		std::vector<ScriptMessage> mainOutbox;
+
+		std::mutex mutex;
+		std::condition_variable startCondition;
+		std::condition_variable doneCondition;
+		unsigned long long generation;
+		int numPending;
+		bool isStopping;
+		WorkerTask task;
+		double deltaTime;
+
+		void CreateBindings(Worker& worker);
+		void RunWorker(Worker& worker);
+		void Process(Worker& worker);
+
+		// Hands the task to every worker and returns once all of them are done
+		void RunTask(WorkerTask task);
+
+	public:
+		ScriptWorkerPool();
+		~ScriptWorkerPool();
+		ScriptWorkerPool(const ScriptWorkerPool&) = delete;
+		ScriptWorkerPool& operator = (const ScriptWorkerPool&) = delete;
+
+		// Zero workers leaves parallel scripts to run as ordinary batches on the main state.
+		// The memory cap applies to each worker state on its own
+		void Start(Registry* registry, int numWorkers, size_t memoryCapBytes, const std::string& cacheDirectory);
+		void Stop();
+		int GetNumWorkers() const;
+
+		// Per worker, applies to running workers and to those started later
+		void SetGcBudgetMicros(int budgetMicros);
+
+		// Loads the script in every worker, -1 when any of them fails
+		int AddGroup(const std::string& filePath);
+
+		// Ids of entities whose transform a worker script wrote are appended here by Run
+		void SetMovedEntityIds(std::vector<int>* movedEntityIds);
+
+		// Sets a global number in every worker state
+		void SetGlobal(const std::string& name, double value);
+
+		void ClearEntities();
+		void AddEntity(int group, const Entity& entity);
+
+		// Runs every group and returns once all workers are done and their commands are applied
+		void Run(double deltaTime);
+
+		// Main state side of kill(entityId), applied right away since the main thread owns the Registry
+		void KillEntity(int entityId);
+
+		// Steps every worker's collector in parallel, once per frame after rendering
+		void StepGarbageCollectors();
+
+		// Main state side of the message queues
+		void PostMessage(const std::string& topic, int entityId, double value);
+		const std::vector<ScriptMessage>& GetMessages() const;
+};
+
+#endif
@@ -0,0 +1,114 @@
+#include "SpatialGrid.h"
+#include <algorithm>
+#include <cmath>
+
+SpatialGrid::SpatialGrid(int cellSize): cellSize(cellSize > 0 ? cellSize : 1) {
+}
+
+long long SpatialGrid::CellKey(int cellX, int cellY) {
+	return (static_cast<long long>(cellX) << 32) ^ static_cast<unsigned int>(cellY);
+}
+
+int SpatialGrid::ToCell(float coordinate) const {
+	return static_cast<int>(std::floor(coordinate / cellSize));
+}
+
+void SpatialGrid::InsertIntoCells(int entityId, const Entry& entry) {
+	for (int cellY = entry.minCellY; cellY <= entry.maxCellY; cellY++) {
+		for (int cellX = entry.minCellX; cellX <= entry.maxCellX; cellX++) {
+			cells[CellKey(cellX, cellY)].push_back(entityId);
+		}
+	}
+}
+
+void SpatialGrid::RemoveFromCells(int entityId, const Entry& entry) {
+	for (int cellY = entry.minCellY; cellY <= entry.maxCellY; cellY++) {
+		for (int cellX = entry.minCellX; cellX <= entry.maxCellX; cellX++) {
+			auto cell = cells.find(CellKey(cellX, cellY));
+			if (cell == cells.end()) {
+				continue;
+			}
+
+			// Order inside a cell does not matter, swap with the last id and pop
+			auto& ids = cell->second;
+			auto it = std::find(ids.begin(), ids.end(), entityId);
+			if (it != ids.end()) {
+				*it = ids.back();
+				ids.pop_back();
+			}
+		}
+	}
+}
+
+void SpatialGrid::Update(int entityId, float x, float y, float width, float height) {
+	if (entityId >= static_cast<int>(entries.size())) {
+		entries.resize(entityId + 1);
+	}
+
+	Entry& entry = entries[entityId];
+	const int minCellX = ToCell(x);
+	const int minCellY = ToCell(y);
+	const int maxCellX = ToCell(x + std::max(width, 0.0f));
+	const int maxCellY = ToCell(y + std::max(height, 0.0f));
+
+	if (entry.isIndexed) {
+		if (entry.minCellX == minCellX && entry.minCellY == minCellY &&
+			entry.maxCellX == maxCellX && entry.maxCellY == maxCellY) {
+			return;
+		}
+		RemoveFromCells(entityId, entry);
+	}
+
+	entry.minCellX = minCellX;
+	entry.minCellY = minCellY;
+	entry.maxCellX = maxCellX;
+	entry.maxCellY = maxCellY;
+	entry.isIndexed = true;
+	InsertIntoCells(entityId, entry);
+}
+
+void SpatialGrid::Remove(int entityId) {
+	if (entityId >= static_cast<int>(entries.size()) || !entries[entityId].isIndexed) {
+		return;
+	}
+	RemoveFromCells(entityId, entries[entityId]);
+	entries[entityId].isIndexed = false;
+}
+
+void SpatialGrid::Clear() {
+	cells.clear();
+	entries.clear();
+}
+
+void SpatialGrid::Query(float x, float y, float width, float height, std::vector<int>& result) {
+	// A fresh stamp marks ids already emitted by this query, so entities spanning several cells appear once
+	queryStamp++;
+	if (queryStamp == 0) {
+		for (auto& entry: entries) {
+			entry.queryStamp = 0;
+		}
+		queryStamp = 1;
+	}
+
+	const int minCellX = ToCell(x);
+	const int minCellY = ToCell(y);
+	const int maxCellX = ToCell(x + width);
+	const int maxCellY = ToCell(y + height);
+
+	for (int cellY = minCellY; cellY <= maxCellY; cellY++) {
+		for (int cellX = minCellX; cellX <= maxCellX; cellX++) {
+			auto cell = cells.find(CellKey(cellX, cellY));
+			if (cell == cells.end()) {
+				continue;
+			}
+
+			for (int entityId: cell->second) {
+				Entry& entry = entries[entityId];
+				if (entry.queryStamp != queryStamp) {
+					entry.queryStamp = queryStamp;
+					result.push_back(entityId);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,49 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include <unordered_map>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// SpatialGrid: Uniform grid of square cells, each listing the entity ids whose bounds overlap it.
+// Cells are hashed so the world does not need fixed bounds; only occupied cells use memory.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class SpatialGrid {
+	private:
+		struct Entry {
+			int minCellX, minCellY;
+			int maxCellX, maxCellY;
+			bool isIndexed = false;
+			unsigned int queryStamp = 0;
+		};
+
+		int cellSize;
+		unsigned int queryStamp = 0;
+
+		// [Key = packed cell coordinates]
+		std::unordered_map<long long, std::vector<int>> cells;
+
+		// [Vector index = entity id]
+		std::vector<Entry> entries;
+
+		static long long CellKey(int cellX, int cellY);
+		int ToCell(float coordinate) const;
+		void InsertIntoCells(int entityId, const Entry& entry);
+		void RemoveFromCells(int entityId, const Entry& entry);
+
+	public:
+		SpatialGrid(int cellSize = 128);
+
+		// Inserts the entity or moves it, cells are only touched when the covered cell range changes
+		void Update(int entityId, float x, float y, float width, float height);
+		void Remove(int entityId);
+		void Clear();
+
+		// Appends every entity whose bounds may overlap the rectangle, each id at most once
+		void Query(float x, float y, float width, float height, std::vector<int>& result);
+
+		int GetCellSize() const { return cellSize; }
+};
+
+#endif
@@ -0,0 +1,251 @@
+#include "Tilemap.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+Tilemap::Tilemap(const std::string& tilesetId, int tileSize, double tileScale):
+	tilesetId(tilesetId), tileSize(tileSize), tileScale(tileScale) {
+}
+
+Tilemap::~Tilemap() {
+	DestroyChunks();
+}
+
+bool Tilemap::LoadMap(const std::string& filePath) {
+	std::ifstream mapFile(filePath);
+	if (!mapFile) {
+		LOG_ERROR("Error opening tilemap %s", filePath.c_str());
+		return false;
+	}
+
+	std::vector<int> loadedTiles;
+	int cols = 0;
+	int rows = 0;
+
+	std::string line;
+	while (std::getline(mapFile, line)) {
+		if (line.empty() || line == "\r") {
+			continue;
+		}
+
+		std::stringstream lineStream(line);
+		std::string cell;
+		int rowCols = 0;
+		while (std::getline(lineStream, cell, ',')) {
+			// Surrounding whitespace, and the \r of CRLF files, is allowed, anything else must be a number
+			const char* start = cell.c_str();
+			while (isspace(static_cast<unsigned char>(*start))) {
+				start++;
+			}
+			if (*start == '\0') {
+				loadedTiles.push_back(TILEMAP_EMPTY_TILE);
+				rowCols++;
+				continue;
+			}
+
+			char* end;
+			errno = 0;
+			const long tile = strtol(start, &end, 10);
+			while (isspace(static_cast<unsigned char>(*end))) {
+				end++;
+			}
+			if (end == start || *end != '\0' || errno == ERANGE || tile < INT_MIN || tile > INT_MAX) {
+				LOG_ERROR("Tilemap %s has an invalid tile \"%s\" on row %d", filePath.c_str(), cell.c_str(), rows + 1);
+				return false;
+			}
+			loadedTiles.push_back(static_cast<int>(tile));
+			rowCols++;
+		}
+
+		if (rows > 0 && rowCols != cols) {
+			LOG_ERROR("Tilemap %s has rows of different lengths", filePath.c_str());
+			return false;
+		}
+		cols = rowCols;
+		rows++;
+	}
+
+	DestroyChunks();
+	tiles = std::move(loadedTiles);
+	mapCols = cols;
+	mapRows = rows;
+	CreateChunks();
+
+	LOG_INFO("Tilemap %s loaded with %dx%d tiles in %zu chunks", filePath.c_str(), mapCols, mapRows, chunks.size());
+	return true;
+}
+
+void Tilemap::CreateChunks() {
+	chunkCols = (mapCols + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE;
+	chunkRows = (mapRows + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE;
+	chunks.resize(chunkCols * chunkRows);
+
+	for (int chunkRow = 0; chunkRow < chunkRows; chunkRow++) {
+		for (int chunkCol = 0; chunkCol < chunkCols; chunkCol++) {
+			TilemapChunk& chunk = chunks[chunkRow * chunkCols + chunkCol];
+			chunk.width = std::min(TILEMAP_CHUNK_SIZE, mapCols - chunkCol * TILEMAP_CHUNK_SIZE);
+			chunk.height = std::min(TILEMAP_CHUNK_SIZE, mapRows - chunkRow * TILEMAP_CHUNK_SIZE);
+		}
+	}
+}
+
+void Tilemap::DestroyChunks() {
+	for (auto& chunk: chunks) {
+		if (chunk.texture) {
+			SDL_DestroyTexture(chunk.texture);
+		}
+	}
+	chunks.clear();
+	chunkCols = 0;
+	chunkRows = 0;
+}
+
+int Tilemap::GetTile(int col, int row) const {
+	if (col < 0 || row < 0 || col >= mapCols || row >= mapRows) {
+		return TILEMAP_EMPTY_TILE;
+	}
+	return tiles[row * mapCols + col];
+}
+
+void Tilemap::SetTile(int col, int row, int tile) {
+	if (col < 0 || row < 0 || col >= mapCols || row >= mapRows) {
+		return;
+	}
+
+	int& current = tiles[row * mapCols + col];
+	if (current == tile) {
+		return;
+	}
+	current = tile;
+
+	// Only the chunk containing the tile needs to be redrawn
+	chunks[(row / TILEMAP_CHUNK_SIZE) * chunkCols + (col / TILEMAP_CHUNK_SIZE)].isDirty = true;
+}
+
+void Tilemap::Invalidate() {
+	for (auto& chunk: chunks) {
+		chunk.isDirty = true;
+	}
+}
+
+void Tilemap::ReleaseTextures() {
+	for (auto& chunk: chunks) {
+		if (chunk.texture) {
+			SDL_DestroyTexture(chunk.texture);
+			chunk.texture = nullptr;
+		}
+		chunk.isDirty = true;
+	}
+}
+
+int Tilemap::GetWidth() const {
+	return static_cast<int>(mapCols * tileSize * tileScale);
+}
+
+int Tilemap::GetHeight() const {
+	return static_cast<int>(mapRows * tileSize * tileScale);
+}
+
+void Tilemap::RenderChunkTiles(SDL_Renderer* renderer, SDL_Texture* tileset, int chunkCol, int chunkRow, const SDL_Rect& dstRect) {
+	const TilemapChunk& chunk = chunks[chunkRow * chunkCols + chunkCol];
+	const double scaleX = static_cast<double>(dstRect.w) / (chunk.width * tileSize);
+	const double scaleY = static_cast<double>(dstRect.h) / (chunk.height * tileSize);
+
+	for (int y = 0; y < chunk.height; y++) {
+		for (int x = 0; x < chunk.width; x++) {
+			int tile = GetTile(chunkCol * TILEMAP_CHUNK_SIZE + x, chunkRow * TILEMAP_CHUNK_SIZE + y);
+			if (tile == TILEMAP_EMPTY_TILE) {
+				continue;
+			}
+
+			SDL_Rect srcRect = {(tile % 10) * tileSize, (tile / 10) * tileSize, tileSize, tileSize};
+
+			// Round both edges so neighbouring tiles never leave a gap when scaled
+			int left = dstRect.x + static_cast<int>(x * tileSize * scaleX);
+			int top = dstRect.y + static_cast<int>(y * tileSize * scaleY);
+			int right = dstRect.x + static_cast<int>((x + 1) * tileSize * scaleX);
+			int bottom = dstRect.y + static_cast<int>((y + 1) * tileSize * scaleY);
+			SDL_Rect tileRect = {left, top, right - left, bottom - top};
+
+			SDL_RenderCopy(renderer, tileset, &srcRect, &tileRect);
+		}
+	}
+}
+
+void Tilemap::RebuildChunk(SDL_Renderer* renderer, SDL_Texture* tileset, TilemapChunk& chunk, int chunkCol, int chunkRow) {
+	// Chunks are cached at tileset resolution, scaling happens when they are blitted
+	const int width = chunk.width * tileSize;
+	const int height = chunk.height * tileSize;
+
+	if (!chunk.texture) {
+		chunk.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+		if (!chunk.texture) {
+			LOG_ERROR("Error creating tilemap chunk texture: %s", SDL_GetError());
+			return;
+		}
+		SDL_SetTextureBlendMode(chunk.texture, SDL_BLENDMODE_BLEND);
+	}
+
+	SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+	SDL_SetRenderTarget(renderer, chunk.texture);
+	SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+	SDL_RenderClear(renderer);
+
+	SDL_Rect chunkRect = {0, 0, width, height};
+	RenderChunkTiles(renderer, tileset, chunkCol, chunkRow, chunkRect);
+
+	SDL_SetRenderTarget(renderer, previousTarget);
+	chunk.isDirty = false;
+}
+
+void Tilemap::Render(SDL_Renderer* renderer, const AssetStore* assetStore, const SDL_Rect& camera) {
+	PROFILE_SCOPE("Tilemap::Render");
+
+	SDL_Texture* tileset = assetStore->GetTexture(tilesetId);
+	if (!tileset || chunks.empty()) {
+		return;
+	}
+
+	const double chunkPixels = TILEMAP_CHUNK_SIZE * tileSize * tileScale;
+
+	// Range of chunks overlapping the camera, everything else is skipped without being looked at
+	int firstCol = std::max(0, static_cast<int>(camera.x / chunkPixels));
+	int firstRow = std::max(0, static_cast<int>(camera.y / chunkPixels));
+	int lastCol = std::min(chunkCols - 1, static_cast<int>((camera.x + camera.w - 1) / chunkPixels));
+	int lastRow = std::min(chunkRows - 1, static_cast<int>((camera.y + camera.h - 1) / chunkPixels));
+
+	const bool canCache = SDL_RenderTargetSupported(renderer);
+
+	for (int chunkRow = firstRow; chunkRow <= lastRow; chunkRow++) {
+		for (int chunkCol = firstCol; chunkCol <= lastCol; chunkCol++) {
+			TilemapChunk& chunk = chunks[chunkRow * chunkCols + chunkCol];
+
+			int left = static_cast<int>(chunkCol * chunkPixels);
+			int top = static_cast<int>(chunkRow * chunkPixels);
+			SDL_Rect dstRect = {
+				left - camera.x,
+				top - camera.y,
+				static_cast<int>(chunkCol * chunkPixels + chunk.width * tileSize * tileScale) - left,
+				static_cast<int>(chunkRow * chunkPixels + chunk.height * tileSize * tileScale) - top
+			};
+
+			if (!canCache) {
+				RenderChunkTiles(renderer, tileset, chunkCol, chunkRow, dstRect);
+				continue;
+			}
+
+			if (chunk.isDirty || !chunk.texture) {
+				RebuildChunk(renderer, tileset, chunk, chunkCol, chunkRow);
+			}
+			if (chunk.texture) {
+				SDL_RenderCopy(renderer, chunk.texture, NULL, &dstRect);
+			}
+		}
+	}
+}
@@ -0,0 +1,74 @@
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include "../AssetStore/AssetStore.h"
+#include <SDL2/SDL.h>
+#include <string>
+#include <vector>
+
+// Number of tiles along each side of a chunk
+const int TILEMAP_CHUNK_SIZE = 32;
+
+// Tile value used for cells that draw nothing
+const int TILEMAP_EMPTY_TILE = -1;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TilemapChunk: A block of tiles pre-rendered into a single target texture.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct TilemapChunk {
+	SDL_Texture* texture = nullptr;
+	int width = 0;  // In tiles, smaller than TILEMAP_CHUNK_SIZE on the right/bottom edges
+	int height = 0;
+	bool isDirty = true;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tilemap: Holds the tile grid of a map and draws it one cached chunk at a time.
+// Tiles use the .map encoding, the tens digit is the tileset row and the units digit the tileset column.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class Tilemap {
+	private:
+		std::string tilesetId;
+		int tileSize;
+		double tileScale;
+
+		int mapCols = 0;
+		int mapRows = 0;
+		std::vector<int> tiles;
+
+		int chunkCols = 0;
+		int chunkRows = 0;
+		std::vector<TilemapChunk> chunks;
+
+		void CreateChunks();
+		void DestroyChunks();
+		void RebuildChunk(SDL_Renderer* renderer, SDL_Texture* tileset, TilemapChunk& chunk, int chunkCol, int chunkRow);
+		void RenderChunkTiles(SDL_Renderer* renderer, SDL_Texture* tileset, int chunkCol, int chunkRow, const SDL_Rect& dstRect);
+
+	public:
+		Tilemap(const std::string& tilesetId, int tileSize, double tileScale);
+		~Tilemap();
+
+		bool LoadMap(const std::string& filePath);
+
+		int GetTile(int col, int row) const;
+		void SetTile(int col, int row, int tile);
+
+		// Forces every chunk to be redrawn, e.g. after the renderer lost the contents of its target textures
+		void Invalidate();
+
+		// Destroys the chunk textures, they are created again on the next Render. Needed when the renderer's
+		// device was reset, which invalidates the textures themselves
+		void ReleaseTextures();
+
+		int GetCols() const { return mapCols; }
+		int GetRows() const { return mapRows; }
+		int GetWidth() const;
+		int GetHeight() const;
+
+		void Render(SDL_Renderer* renderer, const AssetStore* assetStore, const SDL_Rect& camera);
+};
+
+#endif
@@ -0,0 +1,36 @@
+#include "FixedTimestep.h"
+
+FixedTimestep::FixedTimestep(double ticksPerSecond, int maxStepsPerFrame) {
+	SetTickRate(ticksPerSecond);
+	SetMaxStepsPerFrame(maxStepsPerFrame);
+}
+
+void FixedTimestep::SetTickRate(double ticksPerSecond) {
+	stepSeconds = 1.0 / (ticksPerSecond > 0.0 ? ticksPerSecond : 60.0);
+	accumulator = 0.0;
+}
+
+void FixedTimestep::SetMaxStepsPerFrame(int maxSteps) {
+	maxStepsPerFrame = maxSteps > 0 ? maxSteps : 1;
+}
+
+int FixedTimestep::Advance(double frameSeconds) {
+	if (frameSeconds > 0.0) {
+		accumulator += frameSeconds;
+	}
+
+	int steps = static_cast<int>(accumulator / stepSeconds);
+	if (steps > maxStepsPerFrame) {
+		// Keep the fractional part so interpolation stays smooth after catching up
+		double excess = (steps - maxStepsPerFrame) * stepSeconds;
+		droppedSeconds += excess;
+		accumulator -= excess;
+		steps = maxStepsPerFrame;
+	}
+
+	accumulator -= steps * stepSeconds;
+	if (accumulator < 0.0) {
+		accumulator = 0.0;
+	}
+	return steps;
+}
@@ -0,0 +1,42 @@
+#ifndef FIXEDTIMESTEP_H
+#define FIXEDTIMESTEP_H
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FixedTimestep: Accumulates real frame time and hands it out as whole simulation steps of a fixed size.
+// The remainder is exposed as an interpolation factor for rendering between the last two states.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class FixedTimestep {
+	private:
+		double stepSeconds;
+		double accumulator = 0.0;
+		int maxStepsPerFrame;
+
+		unsigned long long tick = 0;
+		double droppedSeconds = 0.0;
+
+	public:
+		FixedTimestep(double ticksPerSecond = 60.0, int maxStepsPerFrame = 5);
+
+		void SetTickRate(double ticksPerSecond);
+		void SetMaxStepsPerFrame(int maxSteps);
+
+		// Adds the real time of the last frame and returns how many steps to simulate now.
+		// Never more than maxStepsPerFrame: time past that is dropped so a slow frame cannot snowball.
+		int Advance(double frameSeconds);
+
+		// Call once per simulated step
+		void Step() { tick++; }
+
+		double GetStepSeconds() const { return stepSeconds; }
+		double GetTickRate() const { return 1.0 / stepSeconds; }
+		unsigned long long GetTick() const { return tick; }
+
+		// Fraction of a step left over after the last Advance, in [0, 1)
+		double GetAlpha() const { return accumulator / stepSeconds; }
+
+		// Total simulation time thrown away by the spiral-of-death guard
+		double GetDroppedSeconds() const { return droppedSeconds; }
+};
+
+#endif
@@ -0,0 +1,88 @@
+#include "FramePacer.h"
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <thread>
+#include <time.h>
+
+FramePacer::FramePacer(double targetFps, int spinMicros) {
+	SetTargetFps(targetFps);
+	SetSpinMicros(spinMicros);
+}
+
+void FramePacer::SetTargetFps(double targetFps) {
+	frameNanos = targetFps > 0.0 ? static_cast<long long>(std::llround(1e9 / targetFps)) : 0;
+	deadlineNanos = 0;
+}
+
+void FramePacer::SetSpinMicros(int spinMicros) {
+	spinNanos = spinMicros > 0 ? spinMicros * 1000LL : 0;
+}
+
+void FramePacer::ResetStats() {
+	stats = FramePacerStats();
+}
+
+long long FramePacer::Now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void FramePacer::SleepUntil(long long targetNanos) {
+#if defined(__linux__)
+	// steady_clock is CLOCK_MONOTONIC on Linux, so the deadline can be handed over as is
+	timespec target;
+	target.tv_sec = targetNanos / 1000000000LL;
+	target.tv_nsec = targetNanos % 1000000000LL;
+	int result;
+	do {
+		// Returns the error instead of setting errno. Only a signal is worth another try, anything else
+		// falls through to the spin in WaitForNextFrame
+		result = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &target, nullptr);
+	} while (result == EINTR);
+#else
+	std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(targetNanos)));
+#endif
+}
+
+double FramePacer::WaitForNextFrame() {
+	long long now = Now();
+
+	if (frameNanos > 0) {
+		if (deadlineNanos == 0) {
+			deadlineNanos = now + frameNanos;
+		}
+
+		// Coarse sleep up to the spin window, then spin on the clock for the remainder
+		if (deadlineNanos - now > spinNanos) {
+			SleepUntil(deadlineNanos - spinNanos);
+		}
+		now = Now();
+		while (now < deadlineNanos) {
+			now = Now();
+		}
+
+		const double errorMicros = (now - deadlineNanos) / 1000.0;
+		stats.lastErrorMicros = errorMicros;
+		stats.maxErrorMicros = std::max(stats.maxErrorMicros, errorMicros);
+		stats.meanAbsErrorMicros += (std::fabs(errorMicros) - stats.meanAbsErrorMicros) / (stats.frames + 1);
+
+		// Deadlines advance by whole periods so rounding never accumulates. When more than a
+		// frame behind, restart from now instead of rushing out frames to catch up.
+		deadlineNanos += frameNanos;
+		if (now - deadlineNanos > 0) {
+			stats.missedDeadlines++;
+			deadlineNanos = now + frameNanos;
+		}
+	} else {
+		stats.lastErrorMicros = 0.0;
+	}
+
+	double frameSeconds = previousFrameNanos != 0 ? (now - previousFrameNanos) / 1e9 : 0.0;
+	previousFrameNanos = now;
+
+	stats.lastFrameSeconds = frameSeconds;
+	stats.frames++;
+	return frameSeconds;
+}
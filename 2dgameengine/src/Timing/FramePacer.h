@@ -0,0 +1,48 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FramePacer: Holds each frame to a target rate against the monotonic clock.
+// Most of the wait is an absolute-deadline sleep, the last stretch is spent spinning so that
+// scheduler wake-up latency does not leak into the frame time.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct FramePacerStats {
+	double lastFrameSeconds = 0.0;
+
+	// Actual wake-up minus the deadline, in microseconds; positive means late
+	double lastErrorMicros = 0.0;
+	double maxErrorMicros = 0.0;
+	double meanAbsErrorMicros = 0.0;
+
+	unsigned long long frames = 0;
+	unsigned long long missedDeadlines = 0;
+};
+
+class FramePacer {
+	private:
+		long long frameNanos = 0;
+		long long spinNanos;
+		long long deadlineNanos = 0;
+		long long previousFrameNanos = 0;
+		FramePacerStats stats;
+
+		static long long Now();
+		static void SleepUntil(long long targetNanos);
+
+	public:
+		// A target of zero or less runs unlocked
+		FramePacer(double targetFps = 60.0, int spinMicros = 500);
+
+		void SetTargetFps(double targetFps);
+		void SetSpinMicros(int spinMicros);
+		bool IsUnlocked() const { return frameNanos == 0; }
+
+		// Blocks until the next frame is due and returns the real seconds since the previous one
+		double WaitForNextFrame();
+
+		const FramePacerStats& GetStats() const { return stats; }
+		void ResetStats();
+};
+
+#endif
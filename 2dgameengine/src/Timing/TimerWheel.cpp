@@ -0,0 +1,55 @@
+#include "TimerWheel.h"
+#include <algorithm>
+
+TimerWheel::TimerWheel() {
+	tick = 0;
+	size = 0;
+}
+
+void TimerWheel::Insert(const Timer& timer) {
+	// Lowest level whose span covers the delay, the slot comes from the expiry's bits at that level
+	const uint64_t delay = timer.expiry - tick;
+	int level = 0;
+	while (level < TIMER_WHEEL_LEVELS - 1 && delay >> (TIMER_WHEEL_SLOT_BITS * (level + 1)) != 0) {
+		level++;
+	}
+	const int slot = (timer.expiry >> (TIMER_WHEEL_SLOT_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+	slots[level][slot].push_back(timer);
+}
+
+void TimerWheel::Cascade(int level, int slot) {
+	cascading.swap(slots[level][slot]);
+	for (const auto& timer: cascading) {
+		Insert(timer);
+	}
+	cascading.clear();
+}
+
+void TimerWheel::Schedule(uint64_t id, uint64_t delayTicks) {
+	delayTicks = std::min(std::max<uint64_t>(delayTicks, 1), TIMER_WHEEL_MAX_DELAY);
+	Insert({id, tick + delayTicks});
+	size++;
+}
+
+void TimerWheel::Advance(std::vector<uint64_t>& due) {
+	tick++;
+
+	// Each time a level wraps, the next slot of the level above is spread over the levels below
+	const int slot = tick & (TIMER_WHEEL_SLOTS - 1);
+	if (slot == 0) {
+		for (int level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+			const int levelSlot = (tick >> (TIMER_WHEEL_SLOT_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+			Cascade(level, levelSlot);
+			if (levelSlot != 0) {
+				break;
+			}
+		}
+	}
+
+	std::vector<Timer>& timers = slots[0][slot];
+	for (const auto& timer: timers) {
+		due.push_back(timer.id);
+	}
+	size -= timers.size();
+	timers.clear();
+}
@@ -0,0 +1,51 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const int TIMER_WHEEL_LEVELS = 4;
+const int TIMER_WHEEL_SLOT_BITS = 8;
+const int TIMER_WHEEL_SLOTS = 1 << TIMER_WHEEL_SLOT_BITS;
+
+// Delays are capped here, a bit over two years at 60 ticks per second
+const uint64_t TIMER_WHEEL_MAX_DELAY = (1ull << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS)) - 1;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TimerWheel: Hierarchical timing wheel of 64-bit ids, due after a whole number of ticks. Level 0 has a slot
+// per tick for the next 256 ticks, each level above covers 256 times the span of the one below. Timers move
+// down a level when the wheel below wraps, so a tick touches only the timers that are due, plus the occasional
+// cascade, however many are waiting. Slots keep their capacity, so a steady state schedules without allocating.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class TimerWheel {
+	private:
+		// The id is as wide as the padding after an int would be, so callers can pack more than an index into it
+		struct Timer {
+			uint64_t id;
+			uint64_t expiry;
+		};
+
+		uint64_t tick;
+		size_t size;
+		std::vector<Timer> slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+		std::vector<Timer> cascading;
+
+		void Insert(const Timer& timer);
+		void Cascade(int level, int slot);
+
+	public:
+		TimerWheel();
+
+		uint64_t GetTick() const { return tick; }
+		size_t GetSize() const { return size; }
+
+		// Due on the Advance that reaches tick + delayTicks, at least the next one
+		void Schedule(uint64_t id, uint64_t delayTicks);
+
+		// Moves to the next tick and appends the ids due on it to due
+		void Advance(std::vector<uint64_t>& due);
+};
+
+#endif
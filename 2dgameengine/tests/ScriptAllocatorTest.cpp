@@ -0,0 +1,219 @@
+// Drives ScriptAllocator the way Lua does, with random allocations, reallocations and frees, and checks that
+// no block is handed out twice, contents survive reallocation and the accounting returns to zero. Also checks
+// what the allocator reports to the AllocationTracker.
+//
+//   ScriptAllocatorTest [--ops 2000000] [--seed 1]
+//
+// Exits with 1 on the first failure.
+
+#include "../src/Scripting/ScriptAllocator.h"
+#include "../src/Logger/Logger.h"
+#include "../src/Profiler/AllocationTracker.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+	struct LiveBlock {
+		unsigned char* data;
+		size_t size;
+		unsigned char pattern;
+	};
+
+	int numFailures = 0;
+
+	void Check(bool condition, const char* what, long long op) {
+		if (!condition) {
+			fprintf(stderr, "FAIL at op %lld: %s\n", op, what);
+			numFailures++;
+		}
+	}
+
+	bool HasPattern(const LiveBlock& block) {
+		for (size_t i = 0; i < block.size; i++) {
+			if (block.data[i] != static_cast<unsigned char>(block.pattern + i)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void Fill(LiveBlock& block) {
+		for (size_t i = 0; i < block.size; i++) {
+			block.data[i] = static_cast<unsigned char>(block.pattern + i);
+		}
+	}
+
+	// Mostly small sizes like Lua's objects, with some large ones to cross the malloc threshold
+	size_t RandomSize(std::mt19937& random) {
+		std::uniform_int_distribution<int> kind(0, 9);
+		if (kind(random) < 8) {
+			return std::uniform_int_distribution<size_t>(1, SCRIPT_ALLOCATOR_MAX_SMALL_SIZE)(random);
+		}
+		return std::uniform_int_distribution<size_t>(1, 4096)(random);
+	}
+
+	void RunRandomOps(long long numOps, unsigned int seed) {
+		ScriptAllocator allocator;
+		std::mt19937 random(seed);
+		std::vector<LiveBlock> blocks;
+		unsigned long long allocations = 0;
+		unsigned long long frees = 0;
+
+		for (long long op = 0; op < numOps && numFailures == 0; op++) {
+			const int action = blocks.empty() ? 0 : std::uniform_int_distribution<int>(0, 2)(random);
+			if (action == 0 || blocks.size() < 64) {
+				LiveBlock block;
+				block.size = RandomSize(random);
+				block.pattern = static_cast<unsigned char>(random());
+				// Lua passes the object type as the old size of a new block, 5 is LUA_TTABLE
+				block.data = static_cast<unsigned char*>(ScriptAllocator::Allocate(&allocator, nullptr, 5, block.size));
+				Check(block.data != nullptr, "allocation failed without a cap", op);
+				if (block.data) {
+					Fill(block);
+					blocks.push_back(block);
+					allocations++;
+				}
+			} else if (action == 1) {
+				const size_t index = random() % blocks.size();
+				LiveBlock& block = blocks[index];
+				const size_t newSize = RandomSize(random);
+				unsigned char* data = static_cast<unsigned char*>(ScriptAllocator::Allocate(&allocator, block.data, block.size, newSize));
+				Check(data != nullptr, "reallocation failed without a cap", op);
+				if (data) {
+					block.data = data;
+					block.size = std::min(block.size, newSize);
+					Check(HasPattern(block), "contents changed by reallocation", op);
+					block.size = newSize;
+					Fill(block);
+				}
+			} else {
+				const size_t index = random() % blocks.size();
+				Check(HasPattern(blocks[index]), "contents overwritten while live", op);
+				ScriptAllocator::Allocate(&allocator, blocks[index].data, blocks[index].size, 0);
+				blocks[index] = blocks.back();
+				blocks.pop_back();
+				frees++;
+			}
+		}
+
+		for (const LiveBlock& block: blocks) {
+			Check(HasPattern(block), "contents overwritten while live", numOps);
+			ScriptAllocator::Allocate(&allocator, block.data, block.size, 0);
+			frees++;
+		}
+
+		const ScriptMemoryStats& stats = allocator.GetStats();
+		Check(stats.bytesInUse == 0, "bytes in use after freeing everything", numOps);
+		Check(stats.largeBytes == 0, "large bytes after freeing everything", numOps);
+		Check(stats.allocations == allocations, "allocation count", numOps);
+		Check(stats.frees == frees, "free count", numOps);
+		printf("random ops: %lld ops, %llu allocations, peak %zu KB, %zu KB of chunks\n",
+			numOps, allocations, stats.peakBytesInUse / 1024, stats.chunkBytes / 1024);
+	}
+
+	// Deltas of the calling thread's tracker counts. Only allocator calls run in between, and the small blocks
+	// fit in the first chunk, so operator new isn't counted even in ALLOC_TRACKING builds
+	void CheckTracked(const AllocationStats& start, uint64_t allocations, uint64_t frees, const char* what) {
+		const AllocationStats end = AllocationTracker::GetThreadStats();
+		Check(end.allocations - start.allocations == allocations, what, 0);
+		Check(end.frees - start.frees == frees, what, 0);
+	}
+
+	void RunTracking() {
+		ScriptAllocator allocator;
+		void* blocks[16];
+
+		// Creates the first chunk, and grows the chunk list, before anything is measured
+		ScriptAllocator::Allocate(&allocator, ScriptAllocator::Allocate(&allocator, nullptr, 0, 16), 16, 0);
+
+		AllocationStats start = AllocationTracker::GetThreadStats();
+		for (int i = 0; i < 16; i++) {
+			blocks[i] = ScriptAllocator::Allocate(&allocator, nullptr, 0, 32);
+		}
+		CheckTracked(start, 16, 0, "new small blocks not reported");
+
+		// Same size class, stays in place
+		start = AllocationTracker::GetThreadStats();
+		blocks[0] = ScriptAllocator::Allocate(&allocator, blocks[0], 32, 30);
+		CheckTracked(start, 0, 0, "in place reallocation reported");
+
+		// Another size class, moves
+		start = AllocationTracker::GetThreadStats();
+		blocks[1] = ScriptAllocator::Allocate(&allocator, blocks[1], 32, 200);
+		CheckTracked(start, 1, 1, "moving reallocation not reported");
+
+		start = AllocationTracker::GetThreadStats();
+		void* large = ScriptAllocator::Allocate(&allocator, nullptr, 0, 4096);
+		CheckTracked(start, 1, 0, "new large block not reported");
+
+		start = AllocationTracker::GetThreadStats();
+		void* grown = ScriptAllocator::Allocate(&allocator, large, 4096, 64 * 1024);
+		CheckTracked(start, grown != large ? 1 : 0, grown != large ? 1 : 0, "large reallocation misreported");
+
+		start = AllocationTracker::GetThreadStats();
+		ScriptAllocator::Allocate(&allocator, grown, 64 * 1024, 0);
+		ScriptAllocator::Allocate(&allocator, blocks[0], 30, 0);
+		ScriptAllocator::Allocate(&allocator, blocks[1], 200, 0);
+		for (int i = 2; i < 16; i++) {
+			ScriptAllocator::Allocate(&allocator, blocks[i], 32, 0);
+		}
+		CheckTracked(start, 0, 17, "frees not reported");
+		printf("tracking: %s\n", numFailures == 0 ? "new blocks, moves and frees reported" : "misreported");
+	}
+
+	void RunCap() {
+		ScriptAllocator allocator;
+		allocator.SetCapBytes(64 * 1024);
+
+		std::vector<void*> blocks;
+		void* block;
+		while ((block = ScriptAllocator::Allocate(&allocator, nullptr, 0, 128)) != nullptr) {
+			blocks.push_back(block);
+		}
+		const ScriptMemoryStats& stats = allocator.GetStats();
+		Check(stats.bytesInUse <= 64 * 1024, "cap exceeded", 0);
+		Check(stats.failedAllocations == 1, "refused allocation not counted", 0);
+		Check(ScriptAllocator::Allocate(&allocator, blocks.back(), 128, 256) == nullptr, "growth past the cap allowed", 0);
+
+		// Shrinking always succeeds, even at the cap
+		void* shrunk = ScriptAllocator::Allocate(&allocator, blocks.back(), 128, 16);
+		Check(shrunk != nullptr, "shrinking refused at the cap", 0);
+		blocks.back() = shrunk;
+
+		for (size_t i = 0; i + 1 < blocks.size(); i++) {
+			ScriptAllocator::Allocate(&allocator, blocks[i], 128, 0);
+		}
+		ScriptAllocator::Allocate(&allocator, blocks.back(), 16, 0);
+		Check(stats.bytesInUse == 0, "bytes in use after freeing everything at the cap", 0);
+		printf("cap: %zu blocks of 128 bytes under a 64 KB cap\n", blocks.size());
+	}
+}
+
+int main(int argc, char* argv[]) {
+	long long numOps = 2000000;
+	unsigned int seed = 1;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+			numOps = strtoll(argv[++i], nullptr, 10);
+		} else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			seed = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+		} else {
+			fprintf(stderr, "Usage: %s [--ops 2000000] [--seed 1]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	// The cap check logs one expected error
+	RunRandomOps(numOps, seed);
+	RunTracking();
+	RunCap();
+
+	Logger::Flush();
+	printf("%s\n", numFailures == 0 ? "PASS" : "FAIL");
+	return numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+// Schedules timers with random delays on a TimerWheel and checks that every one fires exactly once, on the
+// tick it is due, across cascades from every level.
+//
+//   TimerWheelTest [--ticks 3000000] [--timers 10000] [--seed 1]
+//
+// Exits with 1 on the first failure.
+
+#include "../src/Timing/TimerWheel.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+	// Mostly short waits like a script's, with enough long ones to reach the upper levels
+	uint64_t RandomDelay(std::mt19937_64& random) {
+		const int kind = std::uniform_int_distribution<int>(0, 9)(random);
+		if (kind < 6) {
+			return std::uniform_int_distribution<uint64_t>(1, 300)(random);
+		}
+		if (kind < 9) {
+			return std::uniform_int_distribution<uint64_t>(1, 70000)(random);
+		}
+		return std::uniform_int_distribution<uint64_t>(1, 5000000)(random);
+	}
+}
+
+int main(int argc, char* argv[]) {
+	uint64_t numTicks = 3000000;
+	int numTimers = 10000;
+	unsigned long long seed = 1;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+			numTicks = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(argv[i], "--timers") == 0 && i + 1 < argc) {
+			numTimers = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			seed = strtoull(argv[++i], nullptr, 10);
+		} else {
+			fprintf(stderr, "Usage: %s [--ticks 3000000] [--timers 10000] [--seed 1]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	TimerWheel wheel;
+	std::mt19937_64 random(seed);
+
+	// [Vector index = timer id], 0 while the timer isn't scheduled
+	std::vector<uint64_t> dueTicks(numTimers, 0);
+	for (int id = 0; id < numTimers; id++) {
+		const uint64_t delay = RandomDelay(random);
+		dueTicks[id] = wheel.GetTick() + delay;
+		wheel.Schedule(id, delay);
+	}
+
+	std::vector<uint64_t> due;
+	unsigned long long fired = 0;
+	int numFailures = 0;
+	size_t numScheduled = static_cast<size_t>(numTimers);
+
+	for (uint64_t i = 0; i < numTicks && numFailures == 0; i++) {
+		due.clear();
+		wheel.Advance(due);
+		const uint64_t tick = wheel.GetTick();
+
+		for (uint64_t id: due) {
+			if (id >= static_cast<uint64_t>(numTimers) || dueTicks[id] != tick) {
+				fprintf(stderr, "FAIL: timer %llu fired on tick %llu, due on %llu\n", static_cast<unsigned long long>(id),
+					static_cast<unsigned long long>(tick), id < static_cast<uint64_t>(numTimers) ? static_cast<unsigned long long>(dueTicks[id]) : 0ull);
+				numFailures++;
+				break;
+			}
+			fired++;
+			numScheduled--;
+
+			// Scheduled again, like a coroutine that waits in a loop, except for a few that finish
+			if (random() % 64 != 0) {
+				const uint64_t delay = RandomDelay(random);
+				dueTicks[id] = tick + delay;
+				wheel.Schedule(id, delay);
+				numScheduled++;
+			} else {
+				dueTicks[id] = 0;
+			}
+		}
+
+		if (wheel.GetSize() != numScheduled) {
+			fprintf(stderr, "FAIL: wheel holds %zu timers on tick %llu, %zu scheduled\n", wheel.GetSize(),
+				static_cast<unsigned long long>(tick), numScheduled);
+			numFailures++;
+		}
+	}
+
+	// Anything still due by now was missed
+	for (int id = 0; id < numTimers && numFailures == 0; id++) {
+		if (dueTicks[id] != 0 && dueTicks[id] <= wheel.GetTick()) {
+			fprintf(stderr, "FAIL: timer %d due on tick %llu never fired\n", id, static_cast<unsigned long long>(dueTicks[id]));
+			numFailures++;
+		}
+	}
+
+	printf("%llu ticks, %llu timers fired, %zu still waiting\n", static_cast<unsigned long long>(wheel.GetTick()), fired, numScheduled);
+	printf("%s\n", numFailures == 0 ? "PASS" : "FAIL");
+	return numFailures == 0 ? 0 : 1;
+}
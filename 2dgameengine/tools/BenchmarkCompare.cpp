@@ -0,0 +1,396 @@
+// Compares benchmark reports written by BenchmarkReport against a baseline and flags significant changes.
+//
+//   BenchmarkCompare [--threshold 5] <baseline.json> <run.json>...
+//   BenchmarkCompare --merge <baseline.json> <run.json>...
+//
+// Every run file is one independent observation per result: the median of its samples. A merged baseline
+// already stores one observation per run as its samples. Means get 95% confidence intervals from the t
+// distribution, and Welch's t-test decides whether the change is significant. A result regresses when it is
+// significantly slower and by more than the threshold in percent. The exit code is 1 when anything regressed.
+
+#include "../src/Benchmark/BenchmarkReport.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// JsonValue: Just enough JSON to read benchmark reports back
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct JsonValue {
+	enum Type {JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT};
+
+	Type type = JSON_NULL;
+	bool boolean = false;
+	double number = 0.0;
+	std::string text;
+	std::vector<JsonValue> items;
+	std::vector<std::pair<std::string, JsonValue>> members;
+
+	const JsonValue* Find(const char* key) const {
+		for (const auto& member: members) {
+			if (member.first == key) {
+				return &member.second;
+			}
+		}
+		return nullptr;
+	}
+};
+
+class JsonParser {
+	private:
+		const std::string& source;
+		size_t position;
+
+		void SkipSpace() {
+			while (position < source.size() && isspace(static_cast<unsigned char>(source[position]))) {
+				position++;
+			}
+		}
+
+		bool Consume(char c) {
+			SkipSpace();
+			if (position < source.size() && source[position] == c) {
+				position++;
+				return true;
+			}
+			return false;
+		}
+
+		bool ParseString(std::string& out) {
+			if (!Consume('"')) {
+				return false;
+			}
+			while (position < source.size() && source[position] != '"') {
+				char c = source[position++];
+				if (c == '\\' && position < source.size()) {
+					c = source[position++];
+					switch (c) {
+						case 'n': c = '\n'; break;
+						case 't': c = '\t'; break;
+						case 'r': c = '\r'; break;
+						case 'u': position += 4; c = '?'; break;
+						default: break;
+					}
+				}
+				out += c;
+			}
+			return Consume('"');
+		}
+
+	public:
+		JsonParser(const std::string& source): source(source), position(0) {}
+
+		bool Parse(JsonValue& value) {
+			SkipSpace();
+			if (position >= source.size()) {
+				return false;
+			}
+
+			const char c = source[position];
+			if (c == '{') {
+				position++;
+				value.type = JsonValue::JSON_OBJECT;
+				if (Consume('}')) {
+					return true;
+				}
+				do {
+					std::string key;
+					JsonValue member;
+					if (!ParseString(key) || !Consume(':') || !Parse(member)) {
+						return false;
+					}
+					value.members.push_back(std::make_pair(key, member));
+				} while (Consume(','));
+				return Consume('}');
+			}
+			if (c == '[') {
+				position++;
+				value.type = JsonValue::JSON_ARRAY;
+				if (Consume(']')) {
+					return true;
+				}
+				do {
+					JsonValue item;
+					if (!Parse(item)) {
+						return false;
+					}
+					value.items.push_back(item);
+				} while (Consume(','));
+				return Consume(']');
+			}
+			if (c == '"') {
+				value.type = JsonValue::JSON_STRING;
+				return ParseString(value.text);
+			}
+			if (source.compare(position, 4, "true") == 0 || source.compare(position, 5, "false") == 0) {
+				value.type = JsonValue::JSON_BOOL;
+				value.boolean = source[position] == 't';
+				position += value.boolean ? 4 : 5;
+				return true;
+			}
+			if (source.compare(position, 4, "null") == 0) {
+				position += 4;
+				return true;
+			}
+
+			char* end = nullptr;
+			value.type = JsonValue::JSON_NUMBER;
+			value.number = strtod(source.c_str() + position, &end);
+			if (end == source.c_str() + position) {
+				return false;
+			}
+			position = end - source.c_str();
+			return true;
+		}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Statistics
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Two sided 95% critical values of Student's t for 1 to 30 degrees of freedom
+static const double tCritical95[] = {
+	12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+	2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+	2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+static double getTCritical(double degreesOfFreedom) {
+	if (degreesOfFreedom < 1.0) {
+		return tCritical95[0];
+	}
+	if (degreesOfFreedom > 30.0) {
+		return 1.960;
+	}
+	return tCritical95[static_cast<int>(degreesOfFreedom) - 1];
+}
+
+struct Observations {
+	std::string unit;
+	std::vector<double> values;
+
+	double GetMean() const {
+		double sum = 0.0;
+		for (double value: values) {
+			sum += value;
+		}
+		return values.empty() ? 0.0 : sum / values.size();
+	}
+
+	double GetVariance() const {
+		if (values.size() < 2) {
+			return 0.0;
+		}
+		const double mean = GetMean();
+		double squares = 0.0;
+		for (double value: values) {
+			squares += (value - mean) * (value - mean);
+		}
+		return squares / (values.size() - 1);
+	}
+
+	// Half width of the 95% confidence interval of the mean
+	double GetConfidence() const {
+		if (values.size() < 2) {
+			return 0.0;
+		}
+		return getTCritical(values.size() - 1.0) * std::sqrt(GetVariance() / values.size());
+	}
+};
+
+// Results keyed by "name@size", in the order first seen
+typedef std::vector<std::pair<std::string, Observations>> ObservationTable;
+
+static Observations& getObservations(ObservationTable& table, const std::string& key) {
+	for (auto& entry: table) {
+		if (entry.first == key) {
+			return entry.second;
+		}
+	}
+	table.push_back(std::make_pair(key, Observations()));
+	return table.back().second;
+}
+
+static bool loadReport(const char* filePath, std::string& suite, ObservationTable& table) {
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file) {
+		fprintf(stderr, "Cannot open %s\n", filePath);
+		return false;
+	}
+	const std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	JsonValue root;
+	JsonParser parser(source);
+	const JsonValue* results = nullptr;
+	if (!parser.Parse(root) || !(results = root.Find("results")) || results->type != JsonValue::JSON_ARRAY) {
+		fprintf(stderr, "%s is not a benchmark report\n", filePath);
+		return false;
+	}
+
+	if (const JsonValue* suiteValue = root.Find("suite")) {
+		suite = suiteValue->text;
+	}
+
+	// Merged baselines hold one observation per run already
+	const JsonValue* metadata = root.Find("metadata");
+	const bool isMerged = metadata && metadata->Find("merged_runs");
+
+	for (const auto& result: results->items) {
+		const JsonValue* name = result.Find("name");
+		const JsonValue* size = result.Find("size");
+		const JsonValue* unit = result.Find("unit");
+		const JsonValue* samples = result.Find("samples");
+		if (!name || !size || !samples || samples->items.empty()) {
+			continue;
+		}
+
+		std::vector<double> values;
+		for (const auto& sample: samples->items) {
+			if (sample.type == JsonValue::JSON_NUMBER) {
+				values.push_back(sample.number);
+			}
+		}
+		if (values.empty()) {
+			continue;
+		}
+
+		Observations& observations = getObservations(table, name->text + "@" + std::to_string(static_cast<long long>(size->number)));
+		observations.unit = unit ? unit->text : "";
+		if (isMerged) {
+			observations.values.insert(observations.values.end(), values.begin(), values.end());
+		} else {
+			observations.values.push_back(BenchmarkReport::GetPercentile(values, 0.5));
+		}
+	}
+	return true;
+}
+
+static int mergeRuns(const char* outputPath, int runCount, char** runPaths) {
+	std::string suite;
+	ObservationTable table;
+	for (int i = 0; i < runCount; i++) {
+		if (!loadReport(runPaths[i], suite, table)) {
+			return 2;
+		}
+	}
+
+	BenchmarkReport report(suite);
+	report.SetMetadata("merged_runs", std::to_string(runCount));
+	for (const auto& entry: table) {
+		const size_t separator = entry.first.rfind('@');
+		BenchmarkResult& result = report.GetResult(entry.first.substr(0, separator), atoll(entry.first.c_str() + separator + 1), entry.second.unit);
+		result.samples = entry.second.values;
+	}
+	return report.WriteJson(outputPath) ? 0 : 2;
+}
+
+int main(int argc, char* argv[]) {
+	double threshold = 5.0;
+	bool isMerge = false;
+	int first = 1;
+
+	while (first < argc && strncmp(argv[first], "--", 2) == 0) {
+		if (strcmp(argv[first], "--threshold") == 0 && first + 1 < argc) {
+			threshold = atof(argv[first + 1]);
+			first += 2;
+		} else if (strcmp(argv[first], "--merge") == 0) {
+			isMerge = true;
+			first++;
+		} else {
+			break;
+		}
+	}
+
+	if (argc - first < 2) {
+		fprintf(stderr, "Usage: %s [--threshold 5] <baseline.json> <run.json>...\n", argv[0]);
+		fprintf(stderr, "       %s --merge <baseline.json> <run.json>...\n", argv[0]);
+		return 2;
+	}
+
+	if (isMerge) {
+		return mergeRuns(argv[first], argc - first - 1, argv + first + 1);
+	}
+
+	std::string baselineSuite;
+	std::string currentSuite;
+	ObservationTable baseline;
+	ObservationTable current;
+	if (!loadReport(argv[first], baselineSuite, baseline)) {
+		return 2;
+	}
+	for (int i = first + 1; i < argc; i++) {
+		if (!loadReport(argv[i], currentSuite, current)) {
+			return 2;
+		}
+	}
+	if (baselineSuite != currentSuite) {
+		fprintf(stderr, "Suite mismatch: baseline is %s, runs are %s\n", baselineSuite.c_str(), currentSuite.c_str());
+		return 2;
+	}
+
+	printf("%-36s %24s %24s %9s  %s\n", "benchmark", "baseline (95% CI)", "current (95% CI)", "change", "verdict");
+
+	int regressions = 0;
+	for (const auto& entry: current) {
+		const Observations& now = entry.second;
+		const Observations* before = nullptr;
+		for (const auto& candidate: baseline) {
+			if (candidate.first == entry.first) {
+				before = &candidate.second;
+			}
+		}
+		if (!before) {
+			printf("%-36s %24s %17.4g ±%-6.2g %9s  new\n", entry.first.c_str(), "-", now.GetMean(), now.GetConfidence(), "");
+			continue;
+		}
+
+		const double beforeMean = before->GetMean();
+		const double nowMean = now.GetMean();
+		const double change = beforeMean != 0.0 ? (nowMean - beforeMean) / beforeMean * 100.0 : 0.0;
+
+		// Welch's t-test, unequal variances and run counts
+		const char* verdict = "same";
+		if (before->values.size() < 2 || now.values.size() < 2) {
+			verdict = "too few runs";
+		} else {
+			const double beforeError = before->GetVariance() / before->values.size();
+			const double nowError = now.GetVariance() / now.values.size();
+			const double standardError = std::sqrt(beforeError + nowError);
+
+			bool isSignificant;
+			if (standardError == 0.0) {
+				isSignificant = nowMean != beforeMean;
+			} else {
+				const double t = (nowMean - beforeMean) / standardError;
+				const double degreesOfFreedom = (beforeError + nowError) * (beforeError + nowError) /
+					(beforeError * beforeError / (before->values.size() - 1) + nowError * nowError / (now.values.size() - 1));
+				isSignificant = std::fabs(t) > getTCritical(degreesOfFreedom);
+			}
+
+			// Every unit reported so far is a time, lower is better
+			if (isSignificant && change > threshold) {
+				verdict = "REGRESSION";
+				regressions++;
+			} else if (isSignificant && change < -threshold) {
+				verdict = "improved";
+			} else if (isSignificant) {
+				verdict = "within threshold";
+			}
+		}
+
+		printf("%-36s %15.4g ±%-7.2g %15.4g ±%-7.2g %+8.1f%%  %s\n", entry.first.c_str(),
+			beforeMean, before->GetConfidence(), nowMean, now.GetConfidence(), change, verdict);
+	}
+
+	printf("\n%d regression%s beyond %.1f%% at 95%% confidence\n", regressions, regressions == 1 ? "" : "s", threshold);
+	return regressions > 0 ? 1 : 0;
+}
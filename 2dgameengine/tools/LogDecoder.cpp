@@ -0,0 +1,134 @@
+// Decodes a binary log written by BinaryLogSink into text or JSON lines.
+//
+//   LogDecoder [--json] <file>
+
+#include "../src/Logger/BinaryLogSink.h"
+#include "../src/Logger/LogFormat.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+static const char* levelNames[] = {"trace", "debug", "info", "warning", "error"};
+
+static void printJsonString(const char* text) {
+	putchar('"');
+	for (const char* c = text; *c; c++) {
+		switch (*c) {
+			case '"': fputs("\\\"", stdout); break;
+			case '\\': fputs("\\\\", stdout); break;
+			case '\n': fputs("\\n", stdout); break;
+			case '\r': fputs("\\r", stdout); break;
+			case '\t': fputs("\\t", stdout); break;
+			default:
+				if (static_cast<unsigned char>(*c) < 0x20) {
+					printf("\\u%04x", *c);
+				} else {
+					putchar(*c);
+				}
+		}
+	}
+	putchar('"');
+}
+
+int main(int argc, char* argv[]) {
+	bool isJson = false;
+	const char* filePath = nullptr;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--json") == 0) {
+			isJson = true;
+		} else {
+			filePath = argv[i];
+		}
+	}
+	if (!filePath) {
+		fprintf(stderr, "usage: %s [--json] <file>\n", argv[0]);
+		return 1;
+	}
+
+	std::ifstream file(filePath, std::ios::binary);
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	BinaryLogHeader header;
+	if (data.size() < sizeof(header)) {
+		fprintf(stderr, "%s: not a binary log\n", filePath);
+		return 1;
+	}
+	memcpy(&header, data.data(), sizeof(header));
+	if (memcmp(header.magic, BINARY_LOG_MAGIC, sizeof(header.magic)) != 0 || header.version != BINARY_LOG_VERSION ||
+		header.blockSize == 0 || header.ringSize % header.blockSize != 0 ||
+		header.ringOffset + header.ringSize > data.size() ||
+		header.formatTableOffset + header.formatTableUsed > data.size()) {
+		fprintf(stderr, "%s: not a binary log or unsupported version\n", filePath);
+		return 1;
+	}
+
+	// Format table: [id][length][bytes]...
+	std::vector<std::string> formats;
+	for (uint64_t offset = 0; offset + sizeof(BinaryLogFormatEntry) <= header.formatTableUsed;) {
+		BinaryLogFormatEntry entry;
+		memcpy(&entry, data.data() + header.formatTableOffset + offset, sizeof(entry));
+		offset += sizeof(entry);
+		if (offset + entry.length > header.formatTableUsed) {
+			break;
+		}
+		if (entry.id >= formats.size()) {
+			formats.resize(entry.id + 1);
+		}
+		formats[entry.id].assign(reinterpret_cast<const char*>(data.data() + header.formatTableOffset + offset), entry.length);
+		offset += entry.length;
+	}
+
+	// Oldest intact block: the one after the block currently being written, once the ring has wrapped
+	uint64_t position = 0;
+	if (header.writePosition > header.ringSize) {
+		position = (header.writePosition / header.blockSize + 1) * header.blockSize - header.ringSize;
+	}
+
+	const uint8_t* ring = data.data() + header.ringOffset;
+	unsigned long long decoded = 0;
+	while (position < header.writePosition) {
+		const uint64_t blockEnd = (position / header.blockSize + 1) * header.blockSize;
+
+		BinaryLogRecordHeader record;
+		uint32_t marker = 0;
+		if (blockEnd - position >= sizeof(record)) {
+			memcpy(&record, ring + position % header.ringSize, sizeof(record));
+			marker = record.marker;
+		}
+		if (marker != BINARY_LOG_RECORD_MARKER || record.size < sizeof(record) || position + record.size > blockEnd ||
+			sizeof(record) + record.payloadSize > record.size) {
+			position = blockEnd;
+			continue;
+		}
+
+		const uint8_t* payload = ring + position % header.ringSize + sizeof(record);
+		const char* format = record.formatId < formats.size() ? formats[record.formatId].c_str() : "<unknown format>";
+		char text[4096];
+		FormatLogMessage(format, payload, record.payloadSize, text, sizeof(text));
+
+		const char* level = record.level < 5 ? levelNames[record.level] : "unknown";
+		if (isJson) {
+			printf("{\"timestamp_ns\":%lld,\"level\":\"%s\",\"format_id\":%u,\"message\":",
+				static_cast<long long>(record.timestamp), level, record.formatId);
+			printJsonString(text);
+			printf("}\n");
+		} else {
+			time_t seconds = static_cast<time_t>(record.timestamp / 1000000000LL);
+			std::tm localTime;
+			localtime_r(&seconds, &localTime);
+			char timeText[32];
+			strftime(timeText, sizeof(timeText), "%m/%d/%Y %H:%M:%S", &localTime);
+			printf("[%s.%06lld] %-7s %s\n", timeText, static_cast<long long>(record.timestamp % 1000000000LL / 1000), level, text);
+		}
+
+		decoded++;
+		position += record.size;
+	}
+
+	fprintf(stderr, "%llu records decoded, %llu written since open\n", decoded, static_cast<unsigned long long>(header.recordCount));
+	return 0;
+}